@@ -0,0 +1,498 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file displaynodebench.cpp
+ *
+ * Micro benchmarks of the display pipeline from SevenSegmentDisplayPrivate down to the element nodes.
+ * No window or OpenGL context is needed; the nodes are updated like on the render thread but never rendered.
+ * Only timings are reported here, the correctness checks are part of SevenSegmentDisplayTest.
+ * Pass e.g. "-o results.csv,csv" for machine readable output.
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <gui/sevensegmentdisplay_p.hpp>
+#include <gui/sevensegmentrenderer.hpp>
+
+#include <memory>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QQuickWindow>
+#include <QSurfaceFormat>
+#include <QtTest>
+
+namespace
+{
+const int digitCounts[] = { 1, 4, 8, 32, 128 };
+const char* const renderModeNames[] = { "nodes", "vertexcolor", "shader", "atlas" };
+const QRectF bounds(0, 0, 1024, 64);
+} // namespace
+
+class DisplayNodeBench: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void display_data() { digitCountData(); }
+	void display()
+	{
+		QFETCH(int, digits);
+
+		SevenSegmentDisplay display;
+		SevenSegmentDisplayPrivate d(&display);
+		d.setDigitCount(digits);
+
+		double value = 0;
+		QBENCHMARK
+		{
+			d.display(value);
+			value = (value < 999) ? value + 1.25 : 0;
+		}
+	}
+
+	void setString_data() { digitCountData(); }
+	void setString()
+	{
+		QFETCH(int, digits);
+
+		DisplayNode node;
+		node.setDigitCount(digits);
+
+		const QString strings[] = { pattern(digits, '1'), pattern(digits, '8') };
+		int i = 0;
+		QBENCHMARK
+		{
+			node.setString(strings[++i & 1]);
+		}
+	}
+
+	/* Raw segment masks against setString() above: no characters are decoded. */
+	void setSegments_data() { digitCountData(); }
+	void setSegments()
+	{
+		QFETCH(int, digits);
+
+		DisplayNode node;
+		node.setDigitCount(digits);
+
+		const QByteArray masks[] = { QByteArray(digits, '\x06'), QByteArray(digits, '\x7f') };
+		int i = 0;
+		QBENCHMARK
+		{
+			const QByteArray& m = masks[++i & 1];
+			node.setSegments(m.constData(), m.size());
+		}
+	}
+
+	void updateGeometryDirty_data() { renderModeData(); }
+	void updateGeometryDirty()
+	{
+		QFETCH(int, digits);
+		QFETCH(int, mode);
+
+		DisplayNode node;
+		prepare(node, digits, mode);
+
+		int i = 0;
+		QBENCHMARK
+		{
+			node.setDigitSize((++i & 1) ? 24 : 25);
+			node.update(bounds);
+		}
+	}
+
+	void updateSegmentsDirty_data() { renderModeData(); }
+	void updateSegmentsDirty()
+	{
+		QFETCH(int, digits);
+		QFETCH(int, mode);
+
+		DisplayNode node;
+		prepare(node, digits, mode);
+
+		// Every digit changes in every iteration
+		const QString strings[] = { pattern(digits, '1'), pattern(digits, '8') };
+		int i = 0;
+		QBENCHMARK
+		{
+			node.setString(strings[++i & 1]);
+			node.update(bounds);
+		}
+	}
+
+	void digitUpdateGeometry()
+	{
+		DigitNode digit(tessellation(DetailMedium));
+		const QRectF rect(0, 0, 20, 30);
+
+		int i = 0;
+		QBENCHMARK
+		{
+			digit.updateGeometry(rect, (++i & 1) ? 4.0 : 4.5);
+		}
+	}
+
+	void elementUpdateGeometry_data()
+	{
+		QTest::addColumn<bool>("dot");
+		QTest::newRow("segment") << false;
+		QTest::newRow("dot") << true;
+	}
+	void elementUpdateGeometry()
+	{
+		QFETCH(bool, dot);
+
+		const Tessellation& shapes = tessellation(DetailMedium);
+		std::unique_ptr<ElementNode> element(dot ? static_cast<ElementNode*>(new DotNode(shapes.dot))
+		                                     : new SegmentNode(shapes.vSegment));
+
+		int i = 0;
+		QBENCHMARK
+		{
+			qreal scale = (++i & 1) ? 4.0 : 4.5;
+			element->updateGeometry(QMatrix(scale, 0, 0, scale, 10, 10));
+		}
+	}
+
+	/* Cost of a full update (new layout and all digits changing) from 8 to 4096 digits.
+	 * Time per digit must stay roughly constant. */
+	void digitScaling_data()
+	{
+		QTest::addColumn<int>("digits");
+		QTest::addColumn<int>("mode");
+
+		for (int mode = SevenSegmentDisplay::RenderSegmentNodes; mode <= SevenSegmentDisplay::RenderShader; ++mode)
+			for (int digits = 8; digits <= 4096; digits *= 8)
+			{
+				QByteArray name = QByteArray(renderModeNames[mode]) + '/' + QByteArray::number(digits);
+				QTest::newRow(name.constData()) << digits << mode;
+			}
+	}
+	void digitScaling()
+	{
+		QFETCH(int, digits);
+		QFETCH(int, mode);
+
+		DisplayNode node;
+		prepare(node, digits, mode);
+
+		const QString strings[] = { pattern(digits, '1'), pattern(digits, '8') };
+		const QRectF wide(0, 0, digits * 16, 64);
+		int i = 0;
+		QBENCHMARK
+		{
+			node.setDigitSize((++i & 1) ? 24 : 25);
+			node.setString(strings[i & 1]);
+			node.update(wide);
+		}
+	}
+
+	void setValueCoalesced_data()
+	{
+		QTest::addColumn<int>("coalesce");
+		QTest::newRow("none") << int(SevenSegmentDisplay::CoalesceNone);
+		QTest::newRow("latest") << int(SevenSegmentDisplay::CoalesceLatest);
+		QTest::newRow("mean") << int(SevenSegmentDisplay::CoalesceMean);
+	}
+	void setValueCoalesced()
+	{
+		QFETCH(int, coalesce);
+
+		SevenSegmentDisplay display;
+		display.setDigitCount(8);
+		display.setPrecision(2);
+		display.setCoalesce(static_cast<SevenSegmentDisplay::Coalesce>(coalesce));
+
+		double value = 0;
+		QBENCHMARK
+		{
+			display.setValue(value);
+			value = (value < 999) ? value + 1.25 : 0;
+		}
+	}
+
+	/* Integer updates against the double path, which falls back to printf beyond 10^18. */
+	void displayInteger_data()
+	{
+		QTest::addColumn<int>("path");
+		QTest::newRow("double") << 0;
+		QTest::newRow("double/printf") << 1;
+		QTest::newRow("integer") << 2;
+		QTest::newRow("integer/hex") << 3;
+	}
+	void displayInteger()
+	{
+		QFETCH(int, path);
+
+		SevenSegmentDisplay display;
+		SevenSegmentDisplayPrivate d(&display);
+		d.setDigitCount(20);
+		d.mRadix = (path == 3) ? 16 : 10;
+
+		qint64 counter = (path == 1) ? Q_INT64_C(1) << 62 : Q_INT64_C(1) << 40;
+		QBENCHMARK
+		{
+			if (path < 2)
+				d.display(static_cast<double>(counter));
+			else
+				d.displayInteger(counter);
+			counter += 4096;
+		}
+	}
+
+	/* Frame time of a window full of changing displays: hard edges, 4x multisampling of the whole window and
+	 * feathered edges. Needs an OpenGL capable platform, e.g. QT_QPA_PLATFORM=xcb. */
+	void frameTime_data()
+	{
+		QTest::addColumn<int>("samples");
+		QTest::addColumn<bool>("antialiasing");
+		QTest::newRow("aliased") << 0 << false;
+		QTest::newRow("msaa4") << 4 << false;
+		QTest::newRow("antialiasing") << 0 << true;
+	}
+	void frameTime()
+	{
+		QFETCH(int, samples);
+		QFETCH(bool, antialiasing);
+
+		QQuickWindow window;
+		QSurfaceFormat format = window.format();
+		format.setSamples(samples);
+		window.setFormat(format);
+		window.resize(1024, 768);
+
+		std::vector<SevenSegmentDisplay*> displays;
+		for (int i = 0; i < 16; ++i)
+		{
+			SevenSegmentDisplay* display = new SevenSegmentDisplay(window.contentItem());
+			display->setRenderMode(SevenSegmentDisplay::RenderVertexColor);
+			display->setAntialiasing(antialiasing);
+			display->setDigitCount(12);
+			display->setDigitSize(40);
+			display->setY(i * 48);
+			displays.push_back(display);
+		}
+
+		QSignalSpy frames(&window, SIGNAL(frameSwapped()));
+		window.show();
+		if (!QTest::qWaitForWindowExposed(&window) || !frames.wait(5000))
+			QSKIP("The platform does not render windows");
+
+		double value = 0;
+		QBENCHMARK
+		{
+			for (SevenSegmentDisplay* display : displays)
+				display->setValue(value);
+			value += 1.25;
+			frames.wait(1000);
+		}
+	}
+
+	/* Frame time of dozens of changing displays per render mode. The atlas displays share one texture.
+	 * Needs an OpenGL capable platform; QT_OPENGL=software compares the modes on a software rasterizer. */
+	void renderModeFrameTime_data()
+	{
+		QTest::addColumn<int>("mode");
+		for (int mode = SevenSegmentDisplay::RenderSegmentNodes; mode <= SevenSegmentDisplay::RenderAtlas; ++mode)
+			QTest::newRow(renderModeNames[mode]) << mode;
+	}
+	void renderModeFrameTime()
+	{
+		QFETCH(int, mode);
+
+		QQuickWindow window;
+		window.resize(1024, 768);
+
+		std::vector<SevenSegmentDisplay*> displays;
+		for (int i = 0; i < 64; ++i)
+		{
+			SevenSegmentDisplay* display = new SevenSegmentDisplay(window.contentItem());
+			display->setRenderMode(static_cast<SevenSegmentDisplay::RenderMode>(mode));
+			display->setDigitCount(8);
+			display->setDigitSize(40);
+			display->setX((i % 4) * 256);
+			display->setY((i / 4) * 48);
+			displays.push_back(display);
+		}
+
+		QSignalSpy frames(&window, SIGNAL(frameSwapped()));
+		window.show();
+		if (!QTest::qWaitForWindowExposed(&window) || !frames.wait(5000))
+			QSKIP("The platform does not render windows");
+		if (mode == SevenSegmentDisplay::RenderAtlas)
+			QCOMPARE(GlyphAtlas::count(), 1);
+
+		double value = 0;
+		QBENCHMARK
+		{
+			for (SevenSegmentDisplay* display : displays)
+				display->setValue(value);
+			value += 1.25;
+			frames.wait(1000);
+		}
+	}
+
+	/* Cost of (re)building a glyph atlas, which happens when the style of the displays changes. */
+	void glyphAtlasRasterize_data()
+	{
+		QTest::addColumn<int>("pixelSize");
+		for (int pixelSize : { 24, 48, maxAtlasPixelSize })
+			QTest::newRow(QByteArray::number(pixelSize).constData()) << pixelSize;
+	}
+	void glyphAtlasRasterize()
+	{
+		QFETCH(int, pixelSize);
+
+		GlyphAtlasKey key;
+		key.pixelSize = pixelSize;
+		key.on = QColor("green").rgba();
+		key.off = QColor("gray").rgba();
+		key.antialiasing = true;
+
+		QImage image;
+		QBENCHMARK
+		{
+			image = GlyphAtlas::rasterize(key);
+		}
+	}
+
+	/* Offscreen rendering throughput in images per second, serial and on the global thread pool. */
+	void rendererThroughput_data()
+	{
+		QTest::addColumn<bool>("parallel");
+		QTest::newRow("serial") << false;
+		QTest::newRow("pool") << true;
+	}
+	void rendererThroughput()
+	{
+		QFETCH(bool, parallel);
+
+		SevenSegmentRenderer renderer;
+		renderer.setDigitCount(8);
+		renderer.setDigitSize(48);
+
+		QStringList strings;
+		for (int i = 0; i < 1024; ++i)
+			strings << QString::number(i * 1.25, 'f', 2);
+		// Allocates the images
+		QVector<QImage> images;
+		QCOMPARE(renderer.render(strings, images), 0);
+
+		qint64 rendered = 0;
+		QElapsedTimer timer;
+		timer.start();
+		do
+		{
+			if (parallel)
+				renderer.render(strings, images);
+			else
+				for (int i = 0; i < strings.size(); ++i)
+					renderer.render(strings.at(i), images[i]);
+			rendered += strings.size();
+		}
+		while (timer.elapsed() < 1000);
+
+		QTest::setBenchmarkResult(rendered * 1000.0 / timer.elapsed(), QTest::FramesPerSecond);
+	}
+
+	/* Cost of collecting render statistics on a full update. */
+	void updateWithStats_data()
+	{
+		QTest::addColumn<bool>("enabled");
+		QTest::newRow("off") << false;
+		QTest::newRow("on") << true;
+	}
+	void updateWithStats()
+	{
+		QFETCH(bool, enabled);
+
+		RenderCounters counters;
+		DisplayNode node;
+		prepare(node, 32, SevenSegmentDisplay::RenderVertexColor);
+		node.setCounters(enabled ? &counters : nullptr);
+
+		const QString strings[] = { pattern(32, '1'), pattern(32, '8') };
+		int i = 0;
+		QBENCHMARK
+		{
+			node.setString(strings[++i & 1]);
+			node.update(bounds);
+		}
+	}
+
+	void feedSetValue()
+	{
+		SevenSegmentFeed feed;
+		double value = 0;
+		QBENCHMARK
+		{
+			feed.setValue(value);
+			value += 1.25;
+		}
+	}
+
+private:
+	static void digitCountData()
+	{
+		QTest::addColumn<int>("digits");
+		for (int digits : digitCounts)
+			QTest::newRow(QByteArray::number(digits).constData()) << digits;
+	}
+
+	static void renderModeData()
+	{
+		QTest::addColumn<int>("digits");
+		QTest::addColumn<int>("mode");
+
+		for (int mode = SevenSegmentDisplay::RenderSegmentNodes; mode <= SevenSegmentDisplay::RenderShader; ++mode)
+			for (int digits : digitCounts)
+			{
+				QByteArray name = QByteArray(renderModeNames[mode]) + '/' + QByteArray::number(digits);
+				QTest::newRow(name.constData()) << digits << mode;
+			}
+	}
+
+	static QString pattern(int digits, char c)
+	{
+		return QString(digits, QLatin1Char(c));
+	}
+
+	static void prepare(DisplayNode& node, int digits, int mode)
+	{
+		node.setDigitCount(digits);
+		node.setRenderMode(static_cast<SevenSegmentDisplay::RenderMode>(mode));
+		node.update(bounds);
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	// Run headless unless a platform is requested explicitly
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QGuiApplication app(argc, argv);
+	DisplayNodeBench bench;
+	return QTest::qExec(&bench, argc, argv);
+}
+
+#include "displaynodebench.moc"
@@ -0,0 +1,330 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file batchnode_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef BATCHNODE_P_HPP_
+#define BATCHNODE_P_HPP_
+
+#include "segmentgeometry_p.hpp"
+
+#include <memory>
+
+#include <QSGGeometryNode>
+#include <QSGVertexColorMaterial>
+
+namespace
+{
+/** \internal Returns the size of the vertex and index data of a geometry in bytes. */
+inline qint64 geometryMemoryUsage(const QSGGeometry& geometry)
+{
+	return qint64(geometry.vertexCount()) * geometry.sizeOfVertex() + qint64(geometry.indexCount()) * geometry.sizeOfIndex();
+}
+} // namespace
+
+/** \internal Common base class for geometry nodes that render all digits of a display at once. */
+class BatchNode: public QSGGeometryNode
+{
+public:
+	virtual ~BatchNode() {}
+
+	inline int getDigitCount() const { return mDigitCount; }
+	/** \internal Resize the vertex buffer.
+	 * The content of the buffer is invalidated, so all digits must be laid out and displayed again. */
+	void setDigitCount(int digitCount)
+	{
+		mDigitCount = digitCount;
+		allocate(digitCount);
+		markDirty(QSGNode::DirtyGeometry);
+	}
+
+	/** \internal Set the colors of enabled and disabled segments.
+	 * All digits must be displayed again afterwards. Returns true if the material was changed. */
+	virtual bool setColors(const QColor& onColor, const QColor& offColor) = 0;
+
+	/** \internal Update the geometry of a single digit.
+	 * \param digit The index of the digit.
+	 * \param rectangle A rectangle in which to layout the digit.
+	 * \param scale The factor to adjust the basic segment sizes.
+	 */
+	virtual void updateGeometry(int digit, const QRectF& rectangle, qreal scale) = 0;
+
+	/** \internal Display a segment code on a single digit. Bit 0-6 control the segments A-G, bit 7 the dot and bit 8
+	 * the colon. Only the elements whose bit is set in flipped need to be written. Returns the count of written
+	 * vertices. */
+	int display(int digit, quint16 code, quint16 flipped)
+	{
+		Q_ASSERT(digit < getDigitCount());
+
+		int vertices = writeCode(digit, code, flipped);
+		markDirty(QSGNode::DirtyGeometry);
+		return vertices;
+	}
+
+	/** \internal Switch to the shapes of a level of detail. Nodes that do not triangulate the elements ignore it.
+	 * The content of the buffer may be invalidated, so all digits must be laid out and displayed again. */
+	virtual void setTessellation(const Tessellation& /*tessellation*/) {}
+
+	/** \internal Set the width of the anti-aliased edges in item coordinates; 0 renders hard edges.
+	 * The content of the buffer may be invalidated, so all digits must be laid out and displayed again. */
+	virtual void setFeather(qreal width) = 0;
+
+	/** \internal Set the ratio between device pixels and item coordinates. Nodes that rasterize the elements use it to
+	 * pick their resolution; it takes effect with the next updateGeometry(). */
+	virtual void setDevicePixelRatio(qreal /*ratio*/) {}
+
+	/** \internal Returns the heap memory of the node in bytes. */
+	virtual qint64 memoryUsage() const = 0;
+
+protected:
+	/** \internal Allocate the vertices of the given count of digits. */
+	virtual void allocate(int digitCount) = 0;
+	/** \internal Write the segment code of a digit into the vertex buffer. Returns the count of written vertices. */
+	virtual int writeCode(int digit, quint16 code, quint16 flipped) = 0;
+
+private:
+	int mDigitCount = 0;
+};
+
+/** \internal Batch node that renders all elements as one indexed, vertex colored triangle list.
+ * Switching a segment on or off is a color write into the vertex buffer instead of a material change, so a display
+ * costs one node and one material regardless of its digit count.
+ * Feathered edges are a ring of transparent vertices around each element, like the smooth rectangles of Qt Quick.
+ * The ring vertices of a digit follow its element vertices; their color never changes. */
+class VertexColorNode: public BatchNode
+{
+public:
+	VertexColorNode():
+		mTessellation(&tessellation(DetailMedium))
+	{
+		setMaterial(&mMaterial);
+		allocate(0);
+	}
+
+	void setTessellation(const Tessellation& tessellation)
+	{
+		if (&tessellation == mTessellation)
+			return;
+
+		mTessellation = &tessellation;
+		allocate(getDigitCount());
+		markDirty(QSGNode::DirtyGeometry);
+	}
+
+	void setFeather(qreal width)
+	{
+		bool feathered = mFeather > 0;
+		mFeather = static_cast<float>(width);
+		if (feathered != (mFeather > 0))
+		{
+			allocate(getDigitCount());
+			markDirty(QSGNode::DirtyGeometry);
+		}
+	}
+
+	bool setColors(const QColor& onColor, const QColor& offColor)
+	{
+		// The vertex color material expects premultiplied colors
+		QRgb on = qPremultiply(onColor.rgba());
+		QRgb off = qPremultiply(offColor.rgba());
+		if (on == mOn && off == mOff)
+			return false;
+
+		// Colors are vertex data, the material never changes
+		mOn = on;
+		mOff = off;
+		return false;
+	}
+
+	void updateGeometry(int digit, const QRectF& rectangle, qreal scale)
+	{
+		Q_ASSERT(digit < getDigitCount());
+
+		QMatrix mats[elementCount];
+		digitTransforms(rectangle, scale, mats);
+
+		// The element vertices are inset and the ring vertices outset by half of the feather width
+		const float half = mFeather / 2;
+		QSGGeometry::ColoredPoint2D* v = mGeometry->vertexDataAsColoredPoint2D() + digit * digitVertices();
+		QSGGeometry::ColoredPoint2D* ring = v + elementVertices();
+		for (int i = 0; i < elementCount; ++i)
+		{
+			const ElementShape& shape = (i < 7) ? mTessellation->segment(segRotation[i]) : mTessellation->dot;
+			for (int j = 0; j < shape.vertexCount; ++j)
+				setPosition(v++, mats[i], shape.x[j], shape.y[j], shape.mx[j] * -half, shape.my[j] * -half);
+
+			if (mFeather <= 0)
+				continue;
+			for (int k = 0; k < shape.outlineCount; ++k, ++ring)
+			{
+				int j = shape.outline[k];
+				setPosition(ring, mats[i], shape.x[j], shape.y[j], shape.mx[j] * half, shape.my[j] * half);
+				ring->r = ring->g = ring->b = ring->a = 0;
+			}
+		}
+
+		markDirty(QSGNode::DirtyGeometry);
+	}
+
+	qint64 memoryUsage() const
+	{
+		return sizeof(VertexColorNode) + sizeof(QSGGeometry) + geometryMemoryUsage(*mGeometry);
+	}
+
+protected:
+	void allocate(int digitCount)
+	{
+		// 16 bit indices as long as possible; 32 bit indices are not available on all OpenGL ES implementations
+		int vertexCount = digitCount * digitVertices();
+		int indexType = (vertexCount <= 0x10000) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		if (!mGeometry || mGeometry->indexType() != indexType)
+		{
+			std::unique_ptr<QSGGeometry> geometry(new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0, 0,
+			                                                      indexType));
+			geometry->setDrawingMode(GL_TRIANGLES);
+			setGeometry(geometry.get());
+			mGeometry = std::move(geometry);
+		}
+
+		const ElementShape& segment = mTessellation->hSegment;
+		const ElementShape& dot = mTessellation->dot;
+		int triangles = 7 * segment.triangleCount() + dotCount * dot.triangleCount();
+		if (mFeather > 0)
+			triangles += 2 * (7 * segment.outlineCount + dotCount * dot.outlineCount);
+		mGeometry->allocate(vertexCount, digitCount * 3 * triangles);
+		if (indexType == GL_UNSIGNED_SHORT)
+			writeIndices(mGeometry->indexDataAsUShort(), digitCount, segment, dot, mFeather > 0);
+		else
+			writeIndices(mGeometry->indexDataAsUInt(), digitCount, segment, dot, mFeather > 0);
+	}
+
+	int writeCode(int digit, quint16 code, quint16 flipped)
+	{
+		const int segVertices = mTessellation->hSegment.vertexCount;
+		int written = 0;
+		QSGGeometry::ColoredPoint2D* v = mGeometry->vertexDataAsColoredPoint2D() + digit * digitVertices();
+		for (int i = 0; i < elementCount; ++i)
+		{
+			const int count = (i < 7) ? segVertices : mTessellation->dot.vertexCount;
+			const quint16 bit = elementBit(i);
+			if (flipped & bit)
+			{
+				// The colon is transparent while off
+				QRgb color = (code & bit) ? mOn : (i < 8) ? mOff : 0;
+				for (int j = 0; j < count; ++j)
+				{
+					v[j].r = qRed(color);
+					v[j].g = qGreen(color);
+					v[j].b = qBlue(color);
+					v[j].a = qAlpha(color);
+				}
+				written += count;
+			}
+			v += count;
+		}
+		return written;
+	}
+
+private:
+	/** \internal Write a prototype vertex scaled and translated by the matrix and moved by an offset. */
+	static inline void setPosition(QSGGeometry::ColoredPoint2D* v, const QMatrix& m, float x, float y, float ox,
+	                               float oy)
+	{
+		v->x = static_cast<float>(x * m.m11() + m.dx()) + ox;
+		v->y = static_cast<float>(y * m.m22() + m.dy()) + oy;
+	}
+
+	/* Dots of a digit: The dot and the two of the colon. */
+	enum { dotCount = elementCount - 7 };
+
+	/** \internal Vertices of the elements of a digit: 7 segments followed by the dots. */
+	inline int elementVertices() const
+	{
+		return 7 * mTessellation->hSegment.vertexCount + dotCount * mTessellation->dot.vertexCount;
+	}
+
+	/** \internal Vertices per digit: The elements followed by their feather rings. */
+	inline int digitVertices() const
+	{
+		int vertices = elementVertices();
+		if (mFeather > 0)
+			vertices += 7 * mTessellation->hSegment.outlineCount + dotCount * mTessellation->dot.outlineCount;
+		return vertices;
+	}
+
+	/** \internal Write the triangulation of all digits. Segment strips and the dot fans are unrolled.
+	 * Each outline edge of a feathered element is bridged to its ring by two triangles. */
+	template<typename T>
+	static void writeIndices(T* index, int digitCount, const ElementShape& segment, const ElementShape& dot,
+	                         bool feathered)
+	{
+		T base = 0;
+		for (int digit = 0; digit < digitCount; ++digit)
+		{
+			T element = base;
+			for (int i = 0; i < 7; ++i, base += segment.vertexCount)
+				for (int j = 0; j + 2 < segment.vertexCount; ++j)
+				{
+					*index++ = base + j;
+					*index++ = base + j + 1;
+					*index++ = base + j + 2;
+				}
+
+			for (int i = 0; i < dotCount; ++i, base += dot.vertexCount)
+				for (int j = 1; j + 1 < dot.vertexCount; ++j)
+				{
+					*index++ = base;
+					*index++ = base + j;
+					*index++ = base + j + 1;
+				}
+
+			if (!feathered)
+				continue;
+			for (int i = 0; i < elementCount; ++i)
+			{
+				const ElementShape& shape = (i < 7) ? segment : dot;
+				for (int k = 0; k < shape.outlineCount; ++k)
+				{
+					int l = (k + 1) % shape.outlineCount;
+					*index++ = element + shape.outline[k];
+					*index++ = element + shape.outline[l];
+					*index++ = base + k;
+					*index++ = element + shape.outline[l];
+					*index++ = base + l;
+					*index++ = base + k;
+				}
+				element += shape.vertexCount;
+				base += shape.outlineCount;
+			}
+		}
+	}
+
+	const Tessellation* mTessellation;
+	std::unique_ptr<QSGGeometry> mGeometry;
+	QSGVertexColorMaterial mMaterial;
+	QRgb mOn = 0;
+	QRgb mOff = 0;
+	float mFeather = 0;
+};
+
+#endif /* BATCHNODE_P_HPP_ */
@@ -27,149 +27,166 @@
 #define DISPLAYNODE_P_HPP_
 
 #include "sevensegmentdisplay.hpp"
+#include "segmentgeometry_p.hpp"
+#include "batchnode_p.hpp"
+#include "segmentshader_p.hpp"
+#include "glyphatlas_p.hpp"
+#include "displaytext_p.hpp"
+#include "timesource_p.hpp"
+#include "valueanimation_p.hpp"
+#include "materialcache_p.hpp"
+#include "vertextransform_p.hpp"
+#include "renderstats_p.hpp"
+#include "tracing_p.hpp"
 
-#include <memory>
 #include <algorithm>
+#include <atomic>
 #include <vector>
 #include <cmath>
 
+#include <QElapsedTimer>
+#include <QQuickWindow>
 #include <QSGGeometryNode>
 #include <QSGSimpleRectNode>
 #include <QMatrix>
+#include <QTimer>
 
-namespace
-{
-/* Sizes in un-scaled coordinate system. */
-Q_CONSTEXPR qreal baseSegLength = 2.0;
-Q_CONSTEXPR qreal baseSegWidth = 0.60;
-Q_CONSTEXPR qreal baseSegGap = 0.45 / 10;
-Q_CONSTEXPR qreal baseDigitHeight = 2 * baseSegLength + baseSegWidth + 4 * baseSegGap;
-
-Q_CONSTEXPR qreal baseDotRadius = baseSegWidth * 0.6;
-Q_CONSTEXPR quint8 dotSegs = 24;
-
-/* 0 0×3F, 1 0×06, 2 0×5B, 3 0×4F, 4 0×66, 5 0×6D, 6 0×7D, 7 0×07, 8 0×7F, 9 0×6F */
-Q_CONSTEXPR quint8 lutSegCode[] =
-{ 0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, 0x7f, 0x6f };
-} // namespace
-
-/** \internal Common base class for scene graph nodes. */
+/** \internal Common base class for scene graph nodes.
+ * An element references its shared prototype and embeds its geometry, so the only separate allocation is the
+ * vertex buffer of the geometry. */
 class ElementNode: public QSGGeometryNode
 {
 public:
 	virtual ~ElementNode() {}
-	/** \internal Update the color of the element. */
-	inline void setColor(const QColor& color)
+	/** \internal Switch to a shared material. Lifetime of the material is managed by the MaterialCache.
+	 * Returns true if the material changed. */
+	inline bool useMaterial(QSGFlatColorMaterial* material)
 	{
-		if (mMaterial->color() == color)
-			return;
-
-		mMaterial->setColor(color);
-		markDirty(QSGNode::DirtyMaterial);
+		/* Material is only marked dirty, when it is changed. */
+		if (material == this->material())
+			return false;
+		setMaterial(material);
+		return true;
 	}
-	/** \internal Update the geometry by mapping all vertices into the coordinate system of the given matrix. */
+	inline int vertexCount() const { return mGeometry.vertexCount(); }
+	/** \internal Update the geometry by mapping all vertices into the coordinate system of the given matrix.
+	 * The matrix must only scale and translate (see digitTransforms()). */
 	void updateGeometry(const QMatrix& mat)
 	{
-		Q_ASSERT(static_cast<size_t>(mGeometry->vertexCount()) == mVertices.size());
+		Q_ASSERT(qFuzzyIsNull(mat.m12()) && qFuzzyIsNull(mat.m21()));
 
-		bool dirty = false;
-		QSGGeometry::Point2D* data = mGeometry->vertexDataAsPoint2D();
-		for (int i = 0; i < mGeometry->vertexCount(); ++i)
-		{
-			// QPointF is is actually QPointDouble! So take care in comparisons!
-			QPointF p = mat.map(mVertices[i]);
-			float pX = static_cast<float>(p.x());
-			float pY = static_cast<float>(p.y());
-			if (!qFuzzyCompare(pX, data[i].x) || !qFuzzyCompare(pY, data[i].y))
-			{
-				data[i].set(pX, pY);
-				dirty = true;
-			}
-		}
-
-		if (dirty)
+		if (scaleTranslate(mX, mY, mGeometry.vertexCount(),
+		                   static_cast<float>(mat.m11()), static_cast<float>(mat.m22()),
+		                   static_cast<float>(mat.dx()), static_cast<float>(mat.dy()),
+		                   mGeometry.vertexDataAsPoint2D()))
 			markDirty(QSGNode::DirtyGeometry);
 	}
 	/** \internal Returns the effective vertex position (only for debugging). */
 	inline QPointF getEffectiveVertex(qint8 no)
 	{
-		if (no < mGeometry->vertexCount())
-			return QPointF(mGeometry->vertexDataAsPoint2D()[no].x, mGeometry->vertexDataAsPoint2D()[no].y);
+		if (no < mGeometry.vertexCount())
+			return QPointF(mGeometry.vertexDataAsPoint2D()[no].x, mGeometry.vertexDataAsPoint2D()[no].y);
 		return QPointF();
 	}
+	/** \internal Switch to the shape of another level of detail.
+	 * The vertices are invalidated, so the geometry must be updated afterwards. */
+	void setShape(const ElementShape& shape)
+	{
+		if (shape.x == mX)
+			return;
+
+		mX = shape.x;
+		mY = shape.y;
+		mGeometry.allocate(shape.vertexCount);
+		markDirty(QSGNode::DirtyGeometry);
+	}
+	/** \internal Returns the heap memory of the element in bytes. */
+	inline qint64 memoryUsage() const
+	{
+		return sizeof(ElementNode) + geometryMemoryUsage(mGeometry);
+	}
 protected:
-	std::vector<QPointF> mVertices;
-	std::unique_ptr<QSGGeometry> mGeometry;
-	std::unique_ptr<QSGFlatColorMaterial> mMaterial;
+	/** \internal Construct an element with a shared prototype as un-scaled vertices. */
+	ElementNode(const ElementShape& shape, GLenum drawingMode):
+		mX(shape.x), mY(shape.y), mGeometry(QSGGeometry::defaultAttributes_Point2D(), shape.vertexCount)
+	{
+		mGeometry.setDrawingMode(drawingMode);
+		setGeometry(&mGeometry);
+	}
+
+	const float* mX;
+	const float* mY;
+	QSGGeometry mGeometry;
 };
 
 /** \internal Scene graph geometry node of a single segment. */
 struct SegmentNode: public ElementNode
 {
-	explicit SegmentNode(qreal deg = 0)
-	{
-		mGeometry = std::unique_ptr<QSGGeometry>(new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 6));
-		mGeometry->setDrawingMode(GL_TRIANGLE_STRIP);
-		setGeometry(mGeometry.get());
-		mMaterial = std::unique_ptr<QSGFlatColorMaterial>(new QSGFlatColorMaterial);
-		setMaterial(mMaterial.get());
-
-		/* Vertices are placed in the center of a 2-dimensional coordinate system to simplify initial rotation.
-		 * The y values are increasing downwards to ease mapping to Quicks coordinate system.
-		 *   /v2---------v4\
-		 * v0               v5
-		 *   \v1---------v3/
-		 * */
-		mVertices.push_back(QPointF(-baseSegLength / 2, 0));
-		mVertices.push_back(QPointF( -baseSegLength / 2 + baseSegWidth / 2, baseSegWidth / 2));
-		mVertices.push_back(QPointF( -baseSegLength / 2 + baseSegWidth / 2, -baseSegWidth / 2));
-		mVertices.push_back(QPointF(baseSegLength / 2 - baseSegWidth / 2, baseSegWidth / 2));
-		mVertices.push_back(QPointF(baseSegLength / 2 - baseSegWidth / 2, -baseSegWidth / 2));
-		mVertices.push_back(QPointF(baseSegLength / 2, 0));
-
-		if (deg)
-		{
-			QMatrix m = QMatrix().rotate(deg);
-			for (QPointF& v : mVertices)
-				v = m.map(v);
-		}
+	explicit SegmentNode(const ElementShape& shape):
+		ElementNode(shape, GL_TRIANGLE_STRIP)
+	{
 	}
 };
 
 /** \internal Scene graph geometry node of a dot. */
 struct DotNode: public ElementNode
 {
-	DotNode()
+	explicit DotNode(const ElementShape& shape):
+		ElementNode(shape, GL_TRIANGLE_FAN)
+	{
+	}
+};
+
+/** \internal Scene graph geometry node of a dot of the colon. The colon has no off state, it is only drawn while
+ * lit. */
+struct ColonNode: public DotNode
+{
+	explicit ColonNode(const ElementShape& shape):
+		DotNode(shape)
 	{
-		mGeometry = std::unique_ptr<QSGGeometry>(new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), dotSegs + 2));
-		mGeometry->setDrawingMode(GL_TRIANGLE_FAN);
-		setGeometry(mGeometry.get());
-		mMaterial = std::unique_ptr<QSGFlatColorMaterial>(new QSGFlatColorMaterial);
-		setMaterial(mMaterial.get());
+	}
 
-		mVertices.push_back(QPointF( 0, 0));
-		mVertices.push_back(QPointF( baseDotRadius, 0));
-		QMatrix m = QMatrix().rotate(360 / dotSegs);
-		for (int i = 2; i < dotSegs + 2; ++i)
-			mVertices.push_back(m.map(mVertices[i - 1]));
+	bool isSubtreeBlocked() const { return !mLit; }
+	inline void setLit(bool lit)
+	{
+		if (lit == mLit)
+			return;
+		mLit = lit;
+		markDirty(QSGNode::DirtySubtreeBlocked);
 	}
+
+private:
+	bool mLit = false;
 };
 
-/** \internal Scene graph node for a single digit (7 segments + dot). */
+/** \internal Scene graph node for a single digit (7 segments, dot and the two dots of the colon). */
 struct DigitNode: public QSGNode
 {
-	/** \internal Construct a new digit. */
-	DigitNode()
+	/** \internal Construct a new digit with the shapes of the given level of detail. */
+	explicit DigitNode(const Tessellation& tessellation)
 	{
 		// Lifetime is managed by scene graph
-		appendChildNode(new SegmentNode());
-		appendChildNode(new SegmentNode(90));
-		appendChildNode(new SegmentNode(90));
-		appendChildNode(new SegmentNode());
-		appendChildNode(new SegmentNode(90));
-		appendChildNode(new SegmentNode(90));
-		appendChildNode(new SegmentNode());
-		appendChildNode(new DotNode);
+		for (int i = 0; i < 7; ++i)
+		{
+			mElements[i] = new SegmentNode(tessellation.segment(segRotation[i]));
+			appendChildNode(mElements[i]);
+		}
+		mElements[7] = new DotNode(tessellation.dot);
+		appendChildNode(mElements[7]);
+		for (int i = 8; i < elementCount; ++i)
+		{
+			mElements[i] = new ColonNode(tessellation.dot);
+			appendChildNode(mElements[i]);
+		}
+	}
+
+	/** \internal Switch to the shapes of another level of detail. The geometry must be updated afterwards. */
+	void setTessellation(const Tessellation& tessellation)
+	{
+		for (int i = 0; i < 7; ++i)
+			mElements[i]->setShape(tessellation.segment(segRotation[i]));
+		for (int i = 7; i < elementCount; ++i)
+			mElements[i]->setShape(tessellation.dot);
 	}
 
 	/** \internal Update the geometry of this digit.
@@ -178,98 +195,67 @@ struct DigitNode: public QSGNode
 	 */
 	inline void updateGeometry(QRectF rectangle, qreal scale)
 	{
-		qreal segWidth = baseSegWidth * scale;
-		qreal segLength = baseSegLength * scale;
-		qreal segGap = baseSegGap * scale;
-		qreal dotRadius = baseDotRadius * scale;
-
-		/* Segments are positioned around the center of the digit, excluding the dot.
-		 * So the digit center must be left justified by the half of the space the dot needs. */
-		qreal digitCenterX = rectangle.center().x() - (2 * dotRadius + segGap) / 2;
-		qreal digitCenterY = rectangle.center().y();
-
-		Q_ASSERT(8 == childCount());
-
-		// QMatrix(qreal m11, qreal m12, qreal m21, qreal m22, qreal dx, qreal dy)
-		// ->       hScaling, vShearing, hShearing,  vScaling,   hTrans,   vTrans
-
-		// (A) top
-		static_cast<ElementNode*>(childAtIndex(0))->updateGeometry(QMatrix(scale, 0, 0, scale, digitCenterX,
-		        digitCenterY - segLength - segGap * 2));
-		// (B) top right
-		static_cast<ElementNode*>(childAtIndex(1))->updateGeometry(QMatrix(scale, 0, 0, scale,
-		        digitCenterX + segLength / 2 + segGap, digitCenterY - segLength / 2 - segGap));
-		// (C) bottom right
-		static_cast<ElementNode*>(childAtIndex(2))->updateGeometry(QMatrix(scale, 0, 0, scale,
-		        digitCenterX + segLength / 2 + segGap, digitCenterY + segLength / 2 + segGap));
-		// (D) bottom
-		static_cast<ElementNode*>(childAtIndex(3))->updateGeometry(QMatrix(scale, 0, 0, scale, digitCenterX,
-		        digitCenterY + segLength + segGap * 2));
-		// (E) bottom left
-		static_cast<ElementNode*>(childAtIndex(4))->updateGeometry(QMatrix(scale, 0, 0, scale,
-		        digitCenterX - segLength / 2 - segGap, digitCenterY + segLength / 2 + segGap));
-		// (F) top left
-		static_cast<ElementNode*>(childAtIndex(5))->updateGeometry(QMatrix(scale, 0, 0, scale,
-		        digitCenterX - segLength / 2 - segGap, digitCenterY - segLength / 2 - segGap));
-		// (G) middle
-		static_cast<ElementNode*>(childAtIndex(6))->updateGeometry(QMatrix(scale, 0, 0, scale, digitCenterX, digitCenterY));
-
-		// The dot is always laid out. Appearance is controlled by color.
-		static_cast<ElementNode*>(childAtIndex(7))->updateGeometry(QMatrix(scale, 0, 0, scale,
-		        digitCenterX + segLength / 2 + segGap + segWidth / 2 + dotRadius +
-		        segGap, digitCenterY + segLength + 2 * segGap + segWidth / 2 - dotRadius));
+		QMatrix mats[elementCount];
+		digitTransforms(rectangle, scale, mats);
+
+		for (int i = 0; i < elementCount; ++i)
+			mElements[i]->updateGeometry(mats[i]);
 
 #if 0
-		qDebug() << "Effective digit size:" << static_cast<ElementNode*>(childAtIndex(3))->getEffectiveVertex(
-		             1).y() - static_cast<ElementNode*>(childAtIndex(0))->getEffectiveVertex(
+		qDebug() << "Effective digit size:" << mElements[3]->getEffectiveVertex(1).y() - mElements[0]->getEffectiveVertex(
 		             2).y();
 #endif
 	}
 
-	/* From QLCDNumber:
-	 * These digits and other symbols can be shown: 0/O, 1, 2, 3, 4, 5/S, 6, 7, 8, 9/g, minus, decimal point,
-	 * A, B, C, D, E, F, h, H, L, o, P, r, u, U, Y, colon, degree sign
-	 * (which is specified as single quote in the string) and space. */
-	inline void display(const QChar c, const QColor& onColor, const QColor& offColor, bool dot = false)
+	/** \internal Display a segment code. Bit 0-6 control the segments A-G, bit 7 the dot and bit 8 the colon.
+	 * Only the elements whose bit is set in flipped are touched. Returns the count of switched materials. */
+	inline int display(quint16 code, quint16 flipped, QSGFlatColorMaterial* onMaterial,
+	                   QSGFlatColorMaterial* offMaterial)
 	{
-		Q_ASSERT(8 == childCount());
-
-		if (c.isDigit()) // Digit: 0-9
+		int switched = 0;
+		for (int i = 0; i < 8; ++i)
 		{
-			quint8 code = lutSegCode[c.digitValue()];
-			quint8 mask = 0x01;
-			for (quint8 i = 0; i < 7; ++i)
-			{
-				/* Segment material is only marked dirty, when color is changed. */
-				static_cast<ElementNode*>(childAtIndex(i))->setColor((code & mask) ? onColor : offColor);
-				mask = mask << 1;
-			}
+			const quint16 bit = elementBit(i);
+			if (flipped & bit)
+				switched += mElements[i]->useMaterial((code & bit) ? onMaterial : offMaterial);
 		}
-		else
+		if (flipped & colonBit)
 		{
-			// Disable all
-			clear(offColor);
-
-			if (c == '-')
-				static_cast<ElementNode*>(childAtIndex(6))->setColor(onColor);
-
-			// TODO: Add other printable symbols
+			for (int i = 8; i < elementCount; ++i)
+			{
+				switched += mElements[i]->useMaterial(onMaterial);
+				static_cast<ColonNode*>(mElements[i])->setLit(code & colonBit);
+			}
 		}
+		return switched;
+	}
 
-		// Dot
-		static_cast<ElementNode*>(lastChild())->setColor(dot ? onColor : offColor);
+	/** \internal Returns the count of vertices of all elements. */
+	inline int vertexCount() const
+	{
+		int count = 0;
+		for (const ElementNode* element : mElements)
+			count += element->vertexCount();
+		return count;
 	}
 
-	inline void clear(const QColor& offColor)
+	/** \internal Returns the heap memory of the digit in bytes. */
+	inline qint64 memoryUsage() const
 	{
-		for (quint8 i = 0; i < childCount(); ++i)
-			static_cast<ElementNode*>(childAtIndex(i))->setColor(offColor);
+		qint64 bytes = sizeof(DigitNode);
+		for (const ElementNode* element : mElements)
+			bytes += element->memoryUsage();
+		return bytes;
 	}
 
 	static Q_DECL_CONSTEXPR qreal width()
 	{
-		return baseSegLength  + baseSegWidth  + 2 * baseSegGap  + 2 * baseDotRadius  + baseSegGap ;
+		return baseDigitWidth;
 	}
+
+private:
+	/* Segments A-G, the dot and the colon. Owned by scene graph. */
+	ElementNode* mElements[elementCount];
 };
 
 /** \internal Root scene graph node of the display. */
@@ -278,39 +264,57 @@ class DisplayNode: public QObject, public QSGSimpleRectNode
 	Q_OBJECT
 
 public:
+	DisplayNode():
+		mCodes(mText.getDigitCount(), 0)
+	{
+	}
+	~DisplayNode()
+	{
+		releaseMaterials();
+	}
+
+	/** \internal Returns the size of the content of a display with the given digit count and digit size. */
+	static QSizeF contentSize(int digitCount, int digitSize)
+	{
+		return QSizeF(DigitNode::width() * digitSize / baseDigitHeight * digitCount, digitSize);
+	}
+
+	/** \internal Collect render statistics into the counters; null switches collection off. */
+	inline void setCounters(RenderCounters* counters) { mCounters = counters; }
+
+	/** \internal Share the segment materials with other displays.
+	 * Must be set before the first update(). Otherwise the display uses a cache of its own. */
+	void setMaterialCache(const QSharedPointer<MaterialCache>& cache)
+	{
+		Q_ASSERT(!mOnMaterial && !mOffMaterial);
+		mMaterialCache = cache;
+	}
+
 	inline int getDigitCount() const { return mDigitCount; }
 	bool setDigitCount(int digitCount)
 	{
-		if (digitCount == mDigitCount)
+		/* TODO: Add automatically adjusting digit count (on invalid value e.g. negative or ?zero?) */
+		if (!mText.setDigitCount(digitCount))
 			return false;
 
-		/* TODO: Add automatically adjusting digit count (on invalid value e.g. negative or ?zero?) */
+		// The text must be set again
 		mDigitCount = digitCount;
+		mCodes.assign(mDigitCount, 0);
+		mSegmentsDirty = true;
 		return true;
 	}
 
-	inline QString getString() const { return mString; }
-	inline bool setString(QString string)
+	inline QString getString() const { return mText.getString(); }
+	inline bool setString(const QString& string)
 	{
-		// Detect overflow; and fill leading digits with ' '
-		// TODO: Maybe use QRegExp("[\.,]") to detect comma as decimal point?
-		int dot = string.count('.');
-		if (string.size() < mDigitCount + dot)
-			string = string.right(mDigitCount + dot).rightJustified(mDigitCount + dot, QLatin1Char(' '));
-		else if (string.size() > mDigitCount + dot)
-		{
-			string = string.left(mDigitCount + dot);
-			emit overflow();
-		}
+		return textChanged(mText.setString(string));
+	}
 
-		if (string != mString)
-		{
-			mString = string;
-			mSegmentsDirty = true;
-			return true;
-		}
-		else
-			return false;
+	/** \internal Display a value in fixed point notation with the given count of decimal places.
+	 * Values in the range of formatFixed() are formatted without any heap allocation. */
+	inline bool setValue(double value, int precision)
+	{
+		return textChanged(mText.setValue(value, precision));
 	}
 
 	inline int getDigitSize() const { return mDigitSize; }
@@ -323,9 +327,45 @@ public:
 		// Calculate needed scale to match requested digit size
 		mScale = mDigitSize / baseDigitHeight;
 		mGeometryDirty = true;
+		updateDetail();
+		return true;
+	}
+
+	inline qreal getDevicePixelRatio() const { return mDevicePixelRatio; }
+	/** \internal Set the ratio between device pixels and the logical pixels of the digit size.
+	 * Together with the digit size it selects the level of detail of the element geometries. */
+	inline bool setDevicePixelRatio(qreal ratio)
+	{
+		if (qFuzzyCompare(ratio, mDevicePixelRatio))
+			return false;
+
+		mDevicePixelRatio = ratio;
+		updateDetail();
+		// Rasterizing nodes pick their resolution with the geometry
+		mGeometryDirty = true;
+		// The feather is one device pixel wide
+		if (mAntialiasing)
+			mFeatherDirty = true;
+		return true;
+	}
+
+	inline bool getAntialiasing() const { return mAntialiasing; }
+	/** \internal Feather the edges of the elements instead of relying on multisampling.
+	 * Flat color materials cannot fade out, so RenderSegmentNodes switches to the vertex colored batch. */
+	inline bool setAntialiasing(bool antialiasing)
+	{
+		if (antialiasing == mAntialiasing)
+			return false;
+
+		mAntialiasing = antialiasing;
+		mFeatherDirty = true;
+		if (mRenderMode == SevenSegmentDisplay::RenderSegmentNodes)
+			mRenderModeDirty = true;
 		return true;
 	}
 
+	inline Detail getDetail() const { return mDetail; }
+
 	inline SevenSegmentDisplay::Alignment getHAlignment() const { return mHAlignment; }
 	inline bool setHAlignment(SevenSegmentDisplay::Alignment hAlignment)
 	{
@@ -346,6 +386,16 @@ public:
 		return true;
 	}
 
+	inline SevenSegmentDisplay::RenderMode getRenderMode() const { return mRenderMode; }
+	inline bool setRenderMode(SevenSegmentDisplay::RenderMode renderMode)
+	{
+		if (renderMode == mRenderMode)
+			return false;
+		mRenderMode = renderMode;
+		mRenderModeDirty = true;
+		return true;
+	}
+
 	inline QColor getBgColor() const { return mBgColor; }
 	inline bool setBgColor(const QColor& bgColor)
 	{
@@ -363,6 +413,7 @@ public:
 			return false;
 		mOnColor = onColor;
 		mSegmentsDirty = true;
+		mColorsDirty = true;
 		return true;
 	}
 
@@ -373,9 +424,72 @@ public:
 			return false;
 		mOffColor = offColor;
 		mSegmentsDirty = true;
+		mColorsDirty = true;
 		return true;
 	}
 
+	/** \internal Set the Latin-1 characters to display.
+	 * The text is right justified into the digits. Dots and colons are merged into the preceding digit, a dot lights
+	 * its dot and a colon the colon that follows it.
+	 * In steady state (unchanged digit count) no heap allocation takes place.
+	 */
+	bool setText(const char* text, int size)
+	{
+		return textChanged(mText.setText(text, size));
+	}
+
+	/** \internal Set one segment mask per digit, bypassing the characters. See DisplayText::setSegments(). */
+	bool setSegments(const char* masks, int size)
+	{
+		return textChanged(mText.setSegments(masks, size));
+	}
+
+	/** \internal The window to request frames from when a shown time changes and to create the glyph atlas of
+	 * RenderAtlas in. Must be set before the first update(). */
+	inline void setWindow(QQuickWindow* window) { mWindow = window; }
+
+	/** \internal Show the time of a clock, stopwatch or countdown instead of the text.
+	 * The time is sampled in preprocess() before each frame. A timer on the render thread requests the next frame
+	 * when the shown time changes, without involving the GUI thread. */
+	void setTimeSource(const TimeSource& source)
+	{
+		mTimeSource = source;
+		mCountdownFinished = false;
+		updatePreprocess();
+		if (source.mode != SevenSegmentDisplay::ModeValue)
+			sampleTime();
+		else if (mTick)
+			mTick->stop();
+	}
+
+	/** \internal Interpolate the value before each frame until the animation ends.
+	 * The time modes take precedence over the animation. */
+	void setAnimation(const ValueAnimation& animation)
+	{
+		mAnimation = animation;
+		updatePreprocess();
+		if (mAnimation.active && mTimeSource.mode == SevenSegmentDisplay::ModeValue)
+			sampleAnimation();
+	}
+
+	/** \internal Called on render thread before each frame while a time is shown or a value is animated. */
+	void preprocess()
+	{
+		bool changed = false;
+		if (mTimeSource.mode != SevenSegmentDisplay::ModeValue)
+			changed = sampleTime();
+		else if (mAnimation.active)
+			changed = sampleAnimation();
+		if (changed)
+			update(mBoundingRect);
+	}
+
+	/** \internal Returns the count of digits whose segments were touched by the last update(). */
+	inline int getTouchedDigitCount() const { return mTouchedDigitCount; }
+
+	/** \internal Returns the segment code of a digit as decoded from the current text. */
+	inline quint16 getCode(int digit) const { return mCodes[digit]; }
+
 	/** \internal Update the display.
 	 * This method should be called from render thread.
 	 * @param boundingRectange The bounding rectangle of the widget.
@@ -383,16 +497,105 @@ public:
 	 */
 	QSizeF update(const QRectF& boundingRectange)
 	{
-		// Check digit count
-		while (childCount() != mDigitCount)
+		SSD_TRACE_SPAN("DisplayNode::update", 0);
+		mBoundingRect = boundingRectange;
+#ifdef SSD_ENABLE_STATS
+		QElapsedTimer timer;
+		if (mCounters)
+			timer.start();
+#endif
+
+		// Drop the nodes of the previous render mode
+		if (mRenderModeDirty)
+		{
+			while (QSGNode* child = firstChild())
+			{
+				removeChildNode(child);
+				delete child;
+			}
+			mBatchNode = nullptr;
+			mDigits.clear();
+			releaseMaterials();
+			mRenderModeDirty = false;
+			mMemoryDirty = true;
+		}
+
+		// Switch the level of detail of existing nodes
+		if (mDetailDirty)
+		{
+			if (mBatchNode)
+				mBatchNode->setTessellation(tessellation(mDetail));
+			for (DigitNode* digit : mDigits)
+				digit->setTessellation(tessellation(mDetail));
+
+			mGeometryDirty = true;
+			mSegmentsDirty = true;
+			mColorsDirty = true;
+			mDetailDirty = false;
+			mMemoryDirty = true;
+		}
+
+		if (mFeatherDirty)
 		{
-			if (childCount() < mDigitCount)
-				appendChildNode(new DigitNode);
-			else
-				removeChildNode(lastChild());
+			if (mBatchNode)
+				mBatchNode->setFeather(feather());
 
 			mGeometryDirty = true;
 			mSegmentsDirty = true;
+			mColorsDirty = true;
+			mFeatherDirty = false;
+			mMemoryDirty = true;
+		}
+
+		// Check digit count
+		if (mRenderMode != SevenSegmentDisplay::RenderSegmentNodes || mAntialiasing)
+		{
+			if (!mBatchNode)
+			{
+				if (mRenderMode == SevenSegmentDisplay::RenderShader)
+					mBatchNode = new ShaderNode;
+				else if (mRenderMode == SevenSegmentDisplay::RenderAtlas)
+					mBatchNode = new AtlasNode(mWindow);
+				else
+					mBatchNode = new VertexColorNode;
+				mBatchNode->setTessellation(tessellation(mDetail));
+				mBatchNode->setFeather(feather());
+				appendChildNode(mBatchNode);
+			}
+
+			if (mBatchNode->getDigitCount() != mDigitCount)
+			{
+				mBatchNode->setDigitCount(mDigitCount);
+				mGeometryDirty = true;
+				mSegmentsDirty = true;
+				mColorsDirty = true;
+				mMemoryDirty = true;
+			}
+		}
+		else
+		{
+			int digitCount = static_cast<int>(mDigits.size());
+			if (digitCount != mDigitCount)
+			{
+				// Grow or shrink at the end in one pass
+				mDigits.reserve(mDigitCount);
+				for (int i = digitCount; i < mDigitCount; ++i)
+				{
+					mDigits.push_back(new DigitNode(tessellation(mDetail)));
+					appendChildNode(mDigits.back());
+				}
+				for (int i = digitCount - 1; i >= mDigitCount; --i)
+				{
+					removeChildNode(mDigits[i]);
+					delete mDigits[i];
+				}
+				mDigits.resize(mDigitCount);
+
+				mGeometryDirty = true;
+				mSegmentsDirty = true;
+				mColorsDirty = true;
+				mMemoryDirty = true;
+			}
 		}
 
 		if (rect() != boundingRectange)
@@ -403,7 +606,7 @@ public:
 
 			// Calculate content size
 			mContentRect.setHeight(mDigitSize);
-			mContentRect.setWidth(DigitNode::width() * mScale * childCount());
+			mContentRect.setWidth(DigitNode::width() * mScale * mDigitCount);
 
 			// Update rectangle of the background to the maximum of the size of the given rectangle and the content size
 			if (rect().size() != mContentRect.size().expandedTo(boundingRectange.size()))
@@ -451,39 +654,80 @@ public:
 		// Update geometry of digits
 		if (mGeometryDirty)
 		{
+			SSD_STAT(mCounters, geometryFrames += 1);
+
 			// Split the content area into digit parts
 			QRectF digitRect = mContentRect;
-			digitRect.setWidth(digitRect.width() / childCount());
+			digitRect.setWidth(digitRect.width() / mDigitCount);
+			if (mBatchNode)
+				mBatchNode->setDevicePixelRatio(mDevicePixelRatio);
 
-			for (int i = 0; i < childCount(); ++i)
+			for (int i = 0; i < mDigitCount; ++i)
 			{
-				DigitNode* digit = static_cast<DigitNode*>(childAtIndex(i));
-
 				// Move digit rectangle to the right position
 				QRectF rect = digitRect;
 				rect.moveLeft(rect.left() + rect.width() * i);
-				digit->updateGeometry(rect, mScale);
+
+				if (mBatchNode)
+					mBatchNode->updateGeometry(i, rect, mScale);
+				else
+					mDigits[i]->updateGeometry(rect, mScale);
 			}
+			SSD_STAT(mCounters, touchedVertices += vertexCount());
 		}
 
 		if (mSegmentsDirty)
 		{
-			qDebug() << "Raw string" << mString;
-
-			int i = mString.size() -1;
-			int j = mDigitCount - 1;
-			while(i >= 0 && j >= 0)
+			SSD_STAT(mCounters, segmentFrames += 1);
+			int vertices = 0;
+			int materials = 0;
+
+			// Colors of all elements must be rewritten
+			QSGFlatColorMaterial* oldOnMaterial = nullptr;
+			QSGFlatColorMaterial* oldOffMaterial = nullptr;
+			if (mColorsDirty)
 			{
-				bool dot = false;
-				while(mString[i].toLatin1() == '.')
+				if (mBatchNode)
+					materials += mBatchNode->setColors(mOnColor, mOffColor);
+				else
 				{
-					dot = true;
-					--i;
+					if (!mMaterialCache)
+						mMaterialCache = QSharedPointer<MaterialCache>(new MaterialCache);
+					oldOnMaterial = mOnMaterial;
+					oldOffMaterial = mOffMaterial;
+					mOnMaterial = mMaterialCache->acquire(mOnColor);
+					mOffMaterial = mMaterialCache->acquire(mOffColor);
 				}
+				mRendered.assign(mDigitCount, InvalidCode);
+				mColorsDirty = false;
+			}
 
-				static_cast<DigitNode*>(childAtIndex(j))->display(mString[i].toLatin1(), mOnColor, mOffColor, dot);
-				--i;
-				--j;
+			// Only touch digits whose code differs from the rendered one
+			mTouchedDigitCount = 0;
+			for (int i = 0; i < mDigitCount; ++i)
+			{
+				quint16 code = mCodes[i];
+				if (code == mRendered[i])
+					continue;
+
+				quint16 flipped = (mRendered[i] == InvalidCode) ? quint16(InvalidCode) : quint16(code ^ mRendered[i]);
+				mRendered[i] = code;
+				++mTouchedDigitCount;
+
+				if (mBatchNode)
+					vertices += mBatchNode->display(i, code, flipped);
+				else
+					materials += mDigits[i]->display(code, flipped, mOnMaterial, mOffMaterial);
+			}
+			SSD_STAT(mCounters, touchedDigits += mTouchedDigitCount);
+			SSD_STAT(mCounters, touchedVertices += vertices);
+			SSD_STAT(mCounters, dirtiedMaterials += materials);
+
+			// Previous materials are released after no element uses them anymore
+			if (mMaterialCache)
+			{
+				mMaterialCache->release(oldOnMaterial);
+				mMaterialCache->release(oldOffMaterial);
 			}
 		}
 
@@ -494,26 +738,235 @@ public:
 		mGeometryDirty = false;
 		mSegmentsDirty = false;
 
+		// Summing up the nodes is O(digits), so it is only done when the node tree changed
+		if (mMemoryDirty)
+		{
+			mNodeMemoryUsage = nodeMemoryUsage();
+			mMemoryDirty = false;
+		}
+		mMemoryUsage = mNodeMemoryUsage + mText.memoryUsage();
+
+		SSD_STAT(mCounters, updateNanoseconds += timer.nsecsElapsed());
 		return mContentRect.size();
 	}
 
+	/** \internal Returns the heap memory of the display in bytes as of the last update.
+	 * Unlike the other getters it may be called from any thread. */
+	inline qint64 getMemoryUsage() const { return mMemoryUsage; }
+
+#ifdef SSD_ENABLE_TRACING
+	/** \internal Finish the trace of a synchronized value when the next frame of the window is swapped.
+	 * Called on render thread. A value whose frame was not swapped yet is superseded. */
+	void traceFrame(QQuickWindow* window, quint64 id)
+	{
+		if (!id)
+			return;
+
+		TraceRecorder& trace = TraceRecorder::instance();
+		if (mTraceId)
+			trace.valueEnd(mTraceId, "superseded");
+		mTraceId = id;
+
+		// The node lives and dies on the render thread, which also emits frameSwapped
+		if (!mFrameConnection)
+		{
+			mFrameConnection = connect(window, &QQuickWindow::frameSwapped, this, [this]()
+			{
+				if (mTraceId)
+					TraceRecorder::instance().valueEnd(mTraceId, "shown");
+				mTraceId = 0;
+			}, Qt::DirectConnection);
+		}
+	}
+#endif
+
 signals:
-	void overflow();
+	/** Emitted on render thread when the countdown ran out. */
+	void countdownFinished();
+	/** Emitted on render thread when the end value of the animation with the serial is shown. */
+	void animationFinished(int serial);
 
 private:
-	QString mString;
-	int mDigitCount = 4;
+	/** \internal Returns the width of the anti-aliased edges in item coordinates. */
+	inline qreal feather() const
+	{
+		return mAntialiasing ? 1 / mDevicePixelRatio : 0;
+	}
+
+	/** \internal Show the current time of the source and schedule the frame of its next change.
+	 * Only the digits whose segments change are touched by the following update. Returns true if the text changed. */
+	bool sampleTime()
+	{
+		qint64 now = monotonicMsecs();
+		char buffer[timeBufferSize];
+		int size = formatTime(mTimeSource.shownAt(now), mTimeSource.precision, buffer, timeBufferSize);
+		bool changed = (size >= 0) && setText(buffer, size);
+
+		qint64 next = mTimeSource.untilChange(now);
+		if (next > 0 && mWindow)
+		{
+			// Created on first use, so it lives on the render thread like the node
+			if (!mTick)
+			{
+				mTick = new QTimer(this);
+				mTick->setSingleShot(true);
+				connect(mTick, &QTimer::timeout, this, [this]()
+				{
+					mWindow->update();
+				});
+			}
+			mTick->start(static_cast<int>(next));
+		}
+		else if (mTick)
+			mTick->stop();
+
+		if (!mCountdownFinished && mTimeSource.isFinished(now))
+		{
+			mCountdownFinished = true;
+			emit countdownFinished();
+		}
+		return changed;
+	}
+
+	/** \internal Show the interpolated value and request the next frame until the end value is shown.
+	 * Returns true if the text changed. */
+	bool sampleAnimation()
+	{
+		qint64 now = monotonicMsecs();
+		bool changed = setValue(mAnimation.valueAt(now), mAnimation.precision);
+		if (mAnimation.progressAt(now) < 1)
+		{
+			if (mWindow)
+				mWindow->update();
+		}
+		else
+		{
+			// The preprocess flag is left alone while the renderer iterates its nodes; the next sync clears it
+			mAnimation.active = false;
+			emit animationFinished(mAnimation.serial);
+		}
+		return changed;
+	}
+
+	/** \internal Preprocess the node while a time is shown or a value is animated. Not called during preprocess(). */
+	void updatePreprocess()
+	{
+		setFlag(QSGNode::UsePreprocess, mTimeSource.mode != SevenSegmentDisplay::ModeValue || mAnimation.active);
+	}
+
+	/** \internal Select the level of detail of the effective digit size.
+	 * The nodes are only re-tessellated when a threshold is crossed. */
+	void updateDetail()
+	{
+		Detail detail = detailForPixelSize(mDigitSize * mDevicePixelRatio);
+		if (detail != mDetail)
+		{
+			mDetail = detail;
+			mDetailDirty = true;
+		}
+	}
+
+	/** \internal Returns the count of vertices of all digits. */
+	int vertexCount() const
+	{
+		if (mBatchNode)
+			return mBatchNode->geometry()->vertexCount();
+		int count = 0;
+		for (const DigitNode* digit : mDigits)
+			count += digit->vertexCount();
+		return count;
+	}
+
+	/** \internal Sum up the heap memory of the nodes, geometries and per digit buffers of the display. */
+	qint64 nodeMemoryUsage() const
+	{
+		qint64 bytes = sizeof(DisplayNode)
+		               + qint64(mCodes.capacity()) * sizeof(quint16) + qint64(mRendered.capacity()) * sizeof(quint16)
+		               + qint64(mDigits.capacity()) * sizeof(DigitNode*);
+		if (mBatchNode)
+			bytes += mBatchNode->memoryUsage();
+		for (const DigitNode* digit : mDigits)
+			bytes += digit->memoryUsage();
+		return bytes;
+	}
+
+	/** \internal Decode a changed text into one segment code per digit.
+	 * Overflows are detected by the owner of the text (e.g. SevenSegmentDisplay) before the node receives it. */
+	bool textChanged(bool changed)
+	{
+		if (changed)
+		{
+			mText.codes(mCodes.data());
+			mSegmentsDirty = true;
+		}
+		return changed;
+	}
+
+	/** \internal Release the segment materials. */
+	void releaseMaterials()
+	{
+		if (mMaterialCache)
+		{
+			mMaterialCache->release(mOnMaterial);
+			mMaterialCache->release(mOffMaterial);
+		}
+		mOnMaterial = nullptr;
+		mOffMaterial = nullptr;
+		mColorsDirty = true;
+	}
+
+	/* Marks a digit whose rendered code is unknown. Outside the range of a segment code, with all bits flipped. */
+	enum { InvalidCode = 0xffff };
+
+	DisplayText mText;
+	int mDigitCount = mText.getDigitCount();
+	/* Segment codes to display and the ones last rendered, one per digit. */
+	std::vector<quint16> mCodes;
+	std::vector<quint16> mRendered;
+	int mTouchedDigitCount = 0;
 	int mDigitSize = 24;
+	qreal mDevicePixelRatio = 1;
+	Detail mDetail = detailForPixelSize(mDigitSize);
 	SevenSegmentDisplay::Alignment mHAlignment = SevenSegmentDisplay::AlignLeft;
 	SevenSegmentDisplay::Alignment mVAlignment = SevenSegmentDisplay::AlignTop;
+	SevenSegmentDisplay::RenderMode mRenderMode = SevenSegmentDisplay::RenderSegmentNodes;
 	QColor mBgColor = QColor(Qt::transparent);
 	QColor mOnColor = QColor("green");
 	QColor mOffColor = QColor("gray");
 
 	bool mGeometryDirty = true;
 	bool mSegmentsDirty = true;
+	bool mColorsDirty = true;
+	bool mRenderModeDirty = false;
+	bool mDetailDirty = false;
+	bool mAntialiasing = false;
+	bool mFeatherDirty = false;
 	qreal mScale = mDigitSize / baseDigitHeight;
 	QRectF mContentRect;
+	/* Bounding rectangle of the last update(). */
+	QRectF mBoundingRect;
+	TimeSource mTimeSource;
+	ValueAnimation mAnimation;
+	bool mCountdownFinished = false;
+	QQuickWindow* mWindow = nullptr;
+	/* Requests the frame of the next change of the shown time. Child of the node. */
+	QTimer* mTick = nullptr;
+	BatchNode* mBatchNode = nullptr; // Owned by scene graph
+	/* Digits of RenderSegmentNodes in child order. Owned by scene graph. */
+	std::vector<DigitNode*> mDigits;
+	std::atomic<qint64> mMemoryUsage { 0 };
+	/* Part of mMemoryUsage that only changes with the node tree, and whether it must be summed up again. */
+	qint64 mNodeMemoryUsage = 0;
+	bool mMemoryDirty = true;
+	QSharedPointer<MaterialCache> mMaterialCache;
+	QSGFlatColorMaterial* mOnMaterial = nullptr; // Owned by mMaterialCache
+	QSGFlatColorMaterial* mOffMaterial = nullptr; // Owned by mMaterialCache
+	RenderCounters* mCounters = nullptr; // Owned by SevenSegmentStats
+#ifdef SSD_ENABLE_TRACING
+	/* Traced value waiting for its frame. */
+	quint64 mTraceId = 0;
+	QMetaObject::Connection mFrameConnection;
+#endif
 };
 
 #endif /* DISPLAYNODE_P_HPP_ */
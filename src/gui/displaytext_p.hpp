@@ -0,0 +1,173 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file displaytext_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef DISPLAYTEXT_P_HPP_
+#define DISPLAYTEXT_P_HPP_
+
+#include "segmentgeometry_p.hpp"
+#include "numberformat_p.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include <QString>
+
+/** \internal The Latin-1 characters or raw segment masks shown by a display, right justified into its digits.
+ * Plain data without any scene graph dependency, so the item keeps a copy on the GUI thread and the node a copy on
+ * the render thread. In steady state (unchanged digit count) no heap allocation takes place.
+ */
+class DisplayText
+{
+public:
+	inline int getDigitCount() const { return mDigitCount; }
+	/** \internal Change the count of digits. The text is cleared and must be set again. */
+	inline bool setDigitCount(int digitCount)
+	{
+		if (digitCount == mDigitCount)
+			return false;
+
+		mDigitCount = digitCount;
+		mText.clear();
+		mRaw = false;
+		return true;
+	}
+
+	inline const char* data() const { return mText.data(); }
+	inline int size() const { return static_cast<int>(mText.size()); }
+	/** \internal Returns true if the data are segment masks instead of characters. */
+	inline bool isRaw() const { return mRaw; }
+	/** \internal Returns the characters; empty for segment masks, which have no characters. */
+	inline QString getString() const { return mRaw ? QString() : QString::fromLatin1(mText.data(), size()); }
+
+	/** \internal Write one segment code per digit. */
+	inline void codes(quint16* codes) const
+	{
+		if (mRaw)
+		{
+			for (char mask : mText)
+				*codes++ = static_cast<quint8>(mask);
+		}
+		else
+			segmentCodes(mText.data(), size(), codes, mDigitCount);
+	}
+
+	/** \internal Set the characters to display. Dots and colons are merged into the preceding digit as its dot or
+	 * the colon that follows it.
+	 * \param overflow Set to true if the text did not fit into the digits; left untouched otherwise.
+	 * \return True if the text changed.
+	 */
+	bool setText(const char* text, int size, bool* overflow = nullptr)
+	{
+		mScratch.assign(text, text + size);
+		return compose(overflow);
+	}
+
+	/** \internal Set one segment mask per digit. Bit 0-6 control the segments A-G, bit 7 the dot.
+	 * Leading digits without a mask stay blank.
+	 * \param overflow Set to true if there are more masks than digits; left untouched otherwise.
+	 * \return True if the masks changed.
+	 */
+	bool setSegments(const char* masks, int size, bool* overflow = nullptr)
+	{
+		mScratch.clear();
+		if (size < mDigitCount)
+			mScratch.insert(mScratch.end(), mDigitCount - size, 0);
+		else if (size > mDigitCount)
+		{
+			// Like text, the leading masks are shown
+			size = mDigitCount;
+			if (overflow)
+				*overflow = true;
+		}
+		mScratch.insert(mScratch.end(), masks, masks + size);
+		return swap(true);
+	}
+
+	bool setString(const QString& string, bool* overflow = nullptr)
+	{
+		// TODO: Maybe use QRegExp("[\.,]") to detect comma as decimal point?
+		mScratch.clear();
+		for (QChar c : string)
+			mScratch.push_back(c.toLatin1());
+		return compose(overflow);
+	}
+
+	/** \internal Display a value in fixed point notation with the given count of decimal places.
+	 * Values in the range of formatFixed() are formatted without any heap allocation. Larger values or precisions are
+	 * formatted by snprintf() right into the scratch buffer, which only allocates while it grows.
+	 */
+	bool setValue(double value, int precision, bool* overflow = nullptr)
+	{
+		char buffer[formatBufferSize];
+		int size = formatFixed(value, precision, buffer, formatBufferSize);
+		if (size >= 0)
+			return setText(buffer, size, overflow);
+
+		size = std::snprintf(nullptr, 0, "%.*f", precision, value);
+		mScratch.resize(size + 1);
+		std::snprintf(mScratch.data(), mScratch.size(), "%.*f", precision, value);
+		mScratch.pop_back();
+		return compose(overflow);
+	}
+
+	/** \internal Returns the heap memory of the buffers in bytes. */
+	inline qint64 memoryUsage() const { return qint64(mText.capacity()) + qint64(mScratch.capacity()); }
+
+private:
+	/** \internal Right justify the characters in the scratch buffer into the digits. Leading digits are filled with
+	 * ' ' in place, so the composition does not allocate once the buffer has grown to the digit count. */
+	bool compose(bool* overflow)
+	{
+		int digits;
+		int size = static_cast<int>(mScratch.size());
+		int length = fittingLength(mScratch.data(), size, mDigitCount, &digits);
+		if (length < size && overflow)
+			*overflow = true;
+		mScratch.resize(length);
+		mScratch.insert(mScratch.begin(), mDigitCount - digits, ' ');
+		return swap(false);
+	}
+
+	/** \internal Take the composed scratch buffer if it differs from the displayed data. */
+	bool swap(bool raw)
+	{
+		if (raw == mRaw && mScratch == mText)
+			return false;
+
+		mText.swap(mScratch);
+		mRaw = raw;
+		return true;
+	}
+
+	/* Displayed characters and a scratch buffer to compose the next ones. */
+	std::vector<char> mText;
+	std::vector<char> mScratch;
+	int mDigitCount = 4;
+	bool mRaw = false;
+};
+
+#endif /* DISPLAYTEXT_P_HPP_ */
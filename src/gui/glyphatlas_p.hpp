@@ -0,0 +1,361 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file glyphatlas_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef GLYPHATLAS_P_HPP_
+#define GLYPHATLAS_P_HPP_
+
+#include "batchnode_p.hpp"
+#include "sevensegmentrenderer.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QQuickWindow>
+#include <QSharedPointer>
+#include <QWeakPointer>
+#include <QSGTexture>
+#include <QSGTextureMaterial>
+
+namespace
+{
+/** \internal Largest digit height in device pixels that is rasterized. The atlas is about 1566 x 1054 pixels (7 MB),
+ * which fits the 2048 pixel textures of most OpenGL implementations. Larger digits are drawn with a magnified atlas. */
+Q_CONSTEXPR int maxAtlasPixelSize = 64;
+} // namespace
+
+/** \internal Style of the glyphs of an atlas. Atlases are textures, so they are bound to the window. */
+struct GlyphAtlasKey
+{
+	QQuickWindow* window = nullptr;
+	int pixelSize = 0;
+	QRgb on = 0;
+	QRgb off = 0;
+	bool antialiasing = false;
+
+	inline bool operator==(const GlyphAtlasKey& other) const
+	{
+		return window == other.window && pixelSize == other.pixelSize && on == other.on && off == other.off
+		       && antialiasing == other.antialiasing;
+	}
+	inline bool operator!=(const GlyphAtlasKey& other) const { return !(*this == other); }
+};
+
+inline uint qHash(const GlyphAtlasKey& key, uint seed = 0)
+{
+	return qHash(quint64(quintptr(key.window)), seed) ^ qHash(quint64(key.on) << 32 | key.off, seed)
+	       ^ uint(key.pixelSize << 1 | int(key.antialiasing));
+}
+
+/** \internal Texture holding the glyphs of all 512 segment codes (the 128 segment patterns with and without the dot
+ * and the colon) in one style. Code c is found in column c % 32 and row c / 32. The glyphs are rasterized by SevenSegmentRenderer,
+ * so they have the shapes of the other render modes. Cells are separated by a transparent gap, so linear filtering
+ * does not bleed into the neighboring glyphs.
+ * Atlases are shared by all displays of the same style and deleted with the last of them. They must only be used
+ * from the render thread of their window.
+ */
+class GlyphAtlas
+{
+public:
+	enum { Columns = 32, Rows = 16, Gap = 2 };
+
+	~GlyphAtlas()
+	{
+		delete mTexture;
+
+		// A new atlas of the same style may have been registered meanwhile
+		Registry& r = registry();
+		QMutexLocker lock(&r.mutex);
+		if (r.atlases.value(mKey).isNull())
+			r.atlases.remove(mKey);
+	}
+	Q_DISABLE_COPY(GlyphAtlas)
+
+	/** \internal Returns the atlas of the style, rasterizing it if no display of the style exists yet. */
+	static QSharedPointer<GlyphAtlas> acquire(const GlyphAtlasKey& key)
+	{
+		Q_ASSERT(key.window);
+
+		Registry& r = registry();
+		QMutexLocker lock(&r.mutex);
+		QSharedPointer<GlyphAtlas> atlas = r.atlases.value(key).toStrongRef();
+		if (!atlas)
+		{
+			atlas = QSharedPointer<GlyphAtlas>(new GlyphAtlas(key));
+			r.atlases.insert(key, atlas);
+		}
+		return atlas;
+	}
+
+	/** \internal Returns the size of the image of an atlas with the given pixel size. */
+	static QSize imageSize(int pixelSize)
+	{
+		int glyphWidth = static_cast<int>(std::ceil(baseDigitWidth * pixelSize / baseDigitHeight));
+		return QSize(Columns * (glyphWidth + Gap) - Gap, Rows * (pixelSize + Gap) - Gap);
+	}
+
+	/** \internal Returns the largest pixel size of an atlas for the window, i.e. maxAtlasPixelSize unless the
+	 * OpenGL context of the window has a smaller texture size limit. */
+	static int maxPixelSize(QQuickWindow* window)
+	{
+		int size = maxAtlasPixelSize;
+		QOpenGLContext* context = window ? window->openglContext() : nullptr;
+		if (context)
+		{
+			GLint limit = 0;
+			context->functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &limit);
+			while (limit > 0 && size > 1 && (imageSize(size).width() > limit || imageSize(size).height() > limit))
+				--size;
+		}
+		return size;
+	}
+
+	/** \internal Returns the count of atlases in use by all windows. */
+	static int count()
+	{
+		Registry& r = registry();
+		QMutexLocker lock(&r.mutex);
+		return r.atlases.size();
+	}
+
+	/** \internal Rasterize the glyphs into an image of premultiplied ARGB, leaving the gaps transparent. */
+	static QImage rasterize(const GlyphAtlasKey& key)
+	{
+		SevenSegmentRenderer renderer;
+		renderer.setDigitCount(1);
+		renderer.setDigitSize(key.pixelSize);
+		renderer.setOnColor(QColor::fromRgba(key.on));
+		renderer.setOffColor(QColor::fromRgba(key.off));
+		renderer.setAntialiasing(key.antialiasing);
+
+		const QSize glyph = renderer.getImageSize();
+		const QSize pitch(glyph.width() + Gap, glyph.height() + Gap);
+		QImage image(Columns * pitch.width() - Gap, Rows * pitch.height() - Gap, QImage::Format_ARGB32_Premultiplied);
+		image.fill(0);
+
+		for (int c = 0; c < Columns * Rows; ++c)
+		{
+			// Paint in place through an image sharing the scanlines of the cell
+			uchar* cell = image.scanLine(c / Columns * pitch.height()) + c % Columns * pitch.width() * 4;
+			QImage view(cell, glyph.width(), glyph.height(), image.bytesPerLine(), image.format());
+			const quint16 code = static_cast<quint16>(c);
+			renderer.paint(&code, view);
+		}
+		return image;
+	}
+
+	inline const GlyphAtlasKey& key() const { return mKey; }
+	inline QSGTexture* texture() const { return mTexture; }
+
+	/** \internal Returns the normalized texture coordinates of the glyph of a segment code. */
+	inline QRectF cell(quint16 code) const
+	{
+		return QRectF((code % Columns) * mColumnPitch, (code / Columns) * mRowPitch, mCellWidth, mCellHeight);
+	}
+
+	/** \internal Returns the size of the texture in bytes. */
+	inline qint64 memoryUsage() const
+	{
+		return qint64(mTexture->textureSize().width()) * mTexture->textureSize().height() * 4;
+	}
+
+private:
+	explicit GlyphAtlas(const GlyphAtlasKey& key):
+		mKey(key)
+	{
+		QImage image = rasterize(key);
+		mTexture = key.window->createTextureFromImage(image, QQuickWindow::TextureHasAlphaChannel);
+		mTexture->setFiltering(QSGTexture::Linear);
+
+		// The renderer lays out a digit of fractional width, the cells follow it exactly
+		qreal digitWidth = baseDigitWidth * key.pixelSize / baseDigitHeight;
+		mCellWidth = digitWidth / image.width();
+		mCellHeight = qreal(key.pixelSize) / image.height();
+		mColumnPitch = qreal(image.width() + Gap) / Columns / image.width();
+		mRowPitch = qreal(image.height() + Gap) / Rows / image.height();
+	}
+
+	struct Registry
+	{
+		QMutex mutex;
+		QHash<GlyphAtlasKey, QWeakPointer<GlyphAtlas>> atlases;
+	};
+	static Registry& registry()
+	{
+		static Registry r;
+		return r;
+	}
+
+	GlyphAtlasKey mKey;
+	QSGTexture* mTexture = nullptr;
+	qreal mCellWidth = 0;
+	qreal mCellHeight = 0;
+	qreal mColumnPitch = 0;
+	qreal mRowPitch = 0;
+};
+
+/** \internal Batch node that draws each digit as one textured quad showing the glyph of its code in a GlyphAtlas.
+ * Switching segments rewrites the texture coordinates of a quad instead of colors or materials. Displays of the same
+ * style share the texture and material state, so the renderer merges them into a single draw call.
+ * The tessellation is ignored, the atlas is rasterized for the digit size in device pixels. */
+class AtlasNode: public BatchNode
+{
+public:
+	/* Two triangles per digit. */
+	enum { DigitVertices = 6 };
+
+	explicit AtlasNode(QQuickWindow* window):
+		mGeometry(QSGGeometry::defaultAttributes_TexturedPoint2D(), 0),
+		mMaxPixelSize(GlyphAtlas::maxPixelSize(window))
+	{
+		mKey.window = window;
+		mGeometry.setDrawingMode(GL_TRIANGLES);
+		setGeometry(&mGeometry);
+		mMaterial.setFiltering(QSGTexture::Linear);
+		setMaterial(&mMaterial);
+	}
+
+	/** \internal The node is not drawn while it has no atlas, so the material never samples a null texture. */
+	bool isSubtreeBlocked() const { return mAtlas.isNull(); }
+
+	bool setColors(const QColor& onColor, const QColor& offColor)
+	{
+		if (onColor.rgba() == mKey.on && offColor.rgba() == mKey.off)
+			return false;
+
+		// Switches to another atlas with the next written digit
+		mKey.on = onColor.rgba();
+		mKey.off = offColor.rgba();
+		return true;
+	}
+
+	void setFeather(qreal width)
+	{
+		mKey.antialiasing = width > 0;
+	}
+
+	void setDevicePixelRatio(qreal ratio)
+	{
+		mDevicePixelRatio = ratio;
+	}
+
+	void updateGeometry(int digit, const QRectF& rectangle, qreal /*scale*/)
+	{
+		Q_ASSERT(digit < getDigitCount());
+
+		mKey.pixelSize = qBound(1, qRound(rectangle.height() * mDevicePixelRatio), mMaxPixelSize);
+		ensureAtlas();
+
+		const QPointF corners[] = { rectangle.topLeft(), rectangle.bottomLeft(), rectangle.topRight(),
+		                            rectangle.bottomLeft(), rectangle.topRight(), rectangle.bottomRight()
+		                          };
+
+		QSGGeometry::TexturedPoint2D* v = mGeometry.vertexDataAsTexturedPoint2D() + digit * DigitVertices;
+		for (const QPointF& c : corners)
+		{
+			v->x = static_cast<float>(c.x());
+			v->y = static_cast<float>(c.y());
+			++v;
+		}
+
+		markDirty(QSGNode::DirtyGeometry);
+	}
+
+	/** \internal Returns the heap memory of the node. The shared atlas is not included. */
+	qint64 memoryUsage() const
+	{
+		return sizeof(AtlasNode) + geometryMemoryUsage(mGeometry) + qint64(mCodes.capacity()) * sizeof(quint16);
+	}
+
+protected:
+	void allocate(int digitCount)
+	{
+		mGeometry.allocate(digitCount * DigitVertices);
+		mCodes.assign(digitCount, 0);
+	}
+
+	int writeCode(int digit, quint16 code, quint16 /*flipped*/)
+	{
+		mCodes[digit] = code;
+		if (ensureAtlas())
+			writeTexCoords(digit, code);
+		return DigitVertices;
+	}
+
+private:
+	/** \internal Switch to the atlas of the current style and rewrite the texture coordinates of all digits.
+	 * Returns false if there is no atlas, i.e. the node has no window or no size yet; it is not drawn until then. */
+	bool ensureAtlas()
+	{
+		if (mAtlas && mAtlas->key() == mKey)
+			return true;
+		if (!mKey.window || mKey.pixelSize <= 0)
+			return false;
+
+		// The previous atlas is released after the material does not reference its texture anymore
+		QSharedPointer<GlyphAtlas> atlas = GlyphAtlas::acquire(mKey);
+		mMaterial.setTexture(atlas->texture());
+		mAtlas.swap(atlas);
+		markDirty(atlas ? QSGNode::DirtyMaterial : QSGNode::DirtyMaterial | QSGNode::DirtySubtreeBlocked);
+
+		for (int i = 0; i < getDigitCount(); ++i)
+			writeTexCoords(i, mCodes[i]);
+		return true;
+	}
+
+	/** \internal Map the quad of a digit to the cell of a code. The vertex order is the one of updateGeometry(). */
+	void writeTexCoords(int digit, quint16 code)
+	{
+		const QRectF cell = mAtlas->cell(code);
+		const QPointF corners[] = { cell.topLeft(), cell.bottomLeft(), cell.topRight(),
+		                            cell.bottomLeft(), cell.topRight(), cell.bottomRight()
+		                          };
+
+		QSGGeometry::TexturedPoint2D* v = mGeometry.vertexDataAsTexturedPoint2D() + digit * DigitVertices;
+		for (const QPointF& c : corners)
+		{
+			v->tx = static_cast<float>(c.x());
+			v->ty = static_cast<float>(c.y());
+			++v;
+		}
+	}
+
+	GlyphAtlasKey mKey;
+	QSharedPointer<GlyphAtlas> mAtlas;
+	QSGGeometry mGeometry;
+	QSGTextureMaterial mMaterial;
+	/* Segment code of each digit, to rewrite the texture coordinates when the atlas changes. */
+	std::vector<quint16> mCodes;
+	qreal mDevicePixelRatio = 1;
+	/* Digits above are drawn with a magnified atlas. */
+	int mMaxPixelSize;
+};
+
+#endif /* GLYPHATLAS_P_HPP_ */
@@ -0,0 +1,139 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file materialcache_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef MATERIALCACHE_P_HPP_
+#define MATERIALCACHE_P_HPP_
+
+#include <QColor>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QWeakPointer>
+#include <QSGFlatColorMaterial>
+
+class QQuickWindow;
+
+/** \internal Reference counted flat color materials shared by all displays of a window.
+ * Elements of the same color reference the same material, so the batch renderer is able to merge them.
+ * The cache must only be used from the render thread of its window.
+ */
+class MaterialCache
+{
+public:
+	MaterialCache() {}
+	~MaterialCache()
+	{
+		for (const Entry& e : mEntries)
+			delete e.material;
+
+		// The window may be gone and its address reused; a new cache may have been registered meanwhile
+		if (mWindow)
+		{
+			Registry& r = registry();
+			QMutexLocker lock(&r.mutex);
+			if (r.caches.value(mWindow).isNull())
+				r.caches.remove(mWindow);
+		}
+	}
+	Q_DISABLE_COPY(MaterialCache)
+
+	/** \internal Returns the cache shared by all displays of the given window. The cache is unregistered when
+	 * the last display of the window releases it. */
+	static QSharedPointer<MaterialCache> forWindow(QQuickWindow* window)
+	{
+		Registry& r = registry();
+		QMutexLocker lock(&r.mutex);
+		QSharedPointer<MaterialCache> cache = r.caches.value(window).toStrongRef();
+		if (!cache)
+		{
+			cache = QSharedPointer<MaterialCache>(new MaterialCache);
+			cache->mWindow = window;
+			r.caches.insert(window, cache);
+		}
+		return cache;
+	}
+
+	/** \internal Returns the count of caches in use by all windows. */
+	static int count()
+	{
+		Registry& r = registry();
+		QMutexLocker lock(&r.mutex);
+		return r.caches.size();
+	}
+
+	/** \internal Returns a material of the given color and increments its reference count. */
+	QSGFlatColorMaterial* acquire(const QColor& color)
+	{
+		Entry& e = mEntries[color.rgba()];
+		if (!e.material)
+		{
+			e.material = new QSGFlatColorMaterial;
+			e.material->setColor(color);
+		}
+		++e.refs;
+		return e.material;
+	}
+
+	/** \internal Decrement the reference count of a material. Unreferenced materials are deleted. */
+	void release(QSGFlatColorMaterial* material)
+	{
+		if (!material)
+			return;
+
+		QHash<QRgb, Entry>::iterator it = mEntries.find(material->color().rgba());
+		Q_ASSERT(it != mEntries.end() && it->material == material);
+		if (--it->refs == 0)
+		{
+			delete it->material;
+			mEntries.erase(it);
+		}
+	}
+
+	/** \internal Returns the count of cached materials. */
+	inline int size() const { return mEntries.size(); }
+
+private:
+	struct Entry
+	{
+		QSGFlatColorMaterial* material = nullptr;
+		int refs = 0;
+	};
+
+	struct Registry
+	{
+		QMutex mutex;
+		QHash<QQuickWindow*, QWeakPointer<MaterialCache>> caches;
+	};
+	static Registry& registry()
+	{
+		static Registry r;
+		return r;
+	}
+
+	QHash<QRgb, Entry> mEntries;
+	QQuickWindow* mWindow = nullptr;
+};
+
+#endif /* MATERIALCACHE_P_HPP_ */
@@ -0,0 +1,269 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file numberformat_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef NUMBERFORMAT_P_HPP_
+#define NUMBERFORMAT_P_HPP_
+
+#include <algorithm>
+#include <cmath>
+
+#include <QtGlobal>
+
+namespace
+{
+/* Largest precision handled by formatFixed(). */
+Q_CONSTEXPR int maxFixedPrecision = 18;
+
+Q_CONSTEXPR double lutPow10[maxFixedPrecision + 1] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+	1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18
+};
+
+/* Sign + 18 digits + decimal point */
+Q_CONSTEXPR int formatBufferSize = 24;
+
+/** \internal Format a value in fixed point notation without heap allocation.
+ * The result equals printf("%.*f", precision, value).
+ * \param value The value to format.
+ * \param precision The count of decimal places.
+ * \param buffer Receives the characters. The result is not terminated.
+ * \param size The size of the buffer. Should be at least formatBufferSize.
+ * \return The count of written characters or -1 when the value is not finite or exceeds the range of the formatter.
+ */
+inline int formatFixed(double value, int precision, char* buffer, int size)
+{
+	if (precision < 0 || precision > maxFixedPrecision || !std::isfinite(value))
+		return -1;
+
+	double magnitude = std::fabs(value);
+	double product = magnitude * lutPow10[precision];
+	if (product >= 1e18)
+		return -1;
+
+	double whole = std::floor(product);
+	double fraction = product - whole;
+	quint64 n = static_cast<quint64>(whole);
+	if (fraction > 0.5)
+		++n;
+	else if (fraction == 0.5)
+	{
+		/* The rounded product may be a tie that is not present in the exact one.
+		 * The residual of the multiplication decides; exact ties are rounded to even like printf does. */
+		double residual = std::fma(magnitude, lutPow10[precision], -product);
+		if (residual > 0 || (residual == 0 && (n & 1)))
+			++n;
+	}
+
+	// Extract digits in reverse order; at least one digit in front of the decimal point
+	char digits[20];
+	int count = 0;
+	do
+	{
+		digits[count++] = static_cast<char>('0' + n % 10);
+		n /= 10;
+	}
+	while (n || count <= precision);
+
+	bool negative = std::signbit(value);
+	int length = negative + count + (precision > 0);
+	if (length > size)
+		return -1;
+
+	char* p = buffer;
+	if (negative)
+		*p++ = '-';
+	while (count > 0)
+	{
+		if (count == precision)
+			*p++ = '.';
+		*p++ = digits[--count];
+	}
+
+	return length;
+}
+
+/* Sign + 64 binary digits */
+Q_CONSTEXPR int integerBufferSize = 72;
+
+/* Largest magnitude of the exponent of a fixed point number that fits into integerBufferSize. */
+Q_CONSTEXPR int maxFixedPointExponent = 48;
+
+/* Digit characters up to radix 16. B and D share the shape of b and d. */
+Q_CONSTEXPR char radixDigits[] = "0123456789ABCDEF";
+
+/** \internal Extract the digits of a magnitude in reverse order. The radix is a constant so the compiler replaces
+ * the division by shifts or a multiplication. Returns the count of digits, at least one. */
+template<unsigned Radix>
+inline int reverseDigits(quint64 magnitude, char* digits)
+{
+	int count = 0;
+	do
+	{
+		digits[count++] = radixDigits[magnitude % Radix];
+		magnitude /= Radix;
+	}
+	while (magnitude);
+	return count;
+}
+
+/** \internal Extract the digits of a magnitude in reverse order. Returns the count of digits or -1 for an unsupported
+ * radix. */
+inline int reverseDigits(quint64 magnitude, int radix, char* digits)
+{
+	switch (radix)
+	{
+	case 2: return reverseDigits<2>(magnitude, digits);
+	case 8: return reverseDigits<8>(magnitude, digits);
+	case 10: return reverseDigits<10>(magnitude, digits);
+	case 16: return reverseDigits<16>(magnitude, digits);
+	default: return -1;
+	}
+}
+
+/** \internal Returns the magnitude of a value; also of the smallest 64 bit integer. */
+inline quint64 magnitude(qint64 value)
+{
+	return (value < 0) ? 0 - static_cast<quint64>(value) : static_cast<quint64>(value);
+}
+
+/** \internal Format an integer with integer arithmetic only. Negative values are signed magnitudes in every radix.
+ * \param value The value to format.
+ * \param radix 2, 8, 10 or 16. Digits above 9 are upper case.
+ * \param buffer Receives the characters. The result is not terminated.
+ * \param size The size of the buffer. Should be at least integerBufferSize.
+ * \return The count of written characters or -1 when the radix is not supported or the buffer is too small.
+ */
+inline int formatInteger(qint64 value, int radix, char* buffer, int size)
+{
+	char digits[64];
+	int count = reverseDigits(magnitude(value), radix, digits);
+	if (count < 0)
+		return -1;
+
+	bool negative = value < 0;
+	int length = negative + count;
+	if (length > size)
+		return -1;
+
+	char* p = buffer;
+	if (negative)
+		*p++ = '-';
+	while (count > 0)
+		*p++ = digits[--count];
+
+	return length;
+}
+
+/** \internal Format the decimal fixed point number mantissa * 10^exponent with integer arithmetic only.
+ * A negative exponent is the count of decimal places, a positive one appends zeros.
+ * \param buffer Receives the characters. The result is not terminated.
+ * \param size The size of the buffer.
+ * \return The count of written characters or -1 when the buffer is too small.
+ */
+inline int formatFixedPoint(qint64 mantissa, int exponent, char* buffer, int size)
+{
+	char digits[20];
+	int count = reverseDigits<10>(magnitude(mantissa), digits);
+
+	// At least one digit in front of the decimal point
+	int places = (exponent < 0) ? -exponent : 0;
+	int zeros = (exponent > 0) ? exponent : 0;
+	int whole = qMax(count - places, 1);
+	bool negative = mantissa < 0;
+	qint64 length = negative + qint64(whole) + zeros + (places ? places + 1 : 0);
+	if (length > size)
+		return -1;
+
+	char* p = buffer;
+	if (negative)
+		*p++ = '-';
+	for (int i = whole - 1; i >= 0; --i)
+		*p++ = (i + places < count) ? digits[i + places] : '0';
+	p = std::fill_n(p, zeros, '0');
+	if (places)
+	{
+		*p++ = '.';
+		for (int i = places - 1; i >= 0; --i)
+			*p++ = (i < count) ? digits[i] : '0';
+	}
+
+	return static_cast<int>(length);
+}
+
+/* Largest count of decimal places of the seconds handled by formatTime(). */
+Q_CONSTEXPR int maxTimePrecision = 3;
+
+/* Hours of 64 bit milliseconds + ":MM:SS" + decimal places */
+Q_CONSTEXPR int timeBufferSize = 32;
+
+/** \internal Format a duration as HH:MM:SS with integer arithmetic only. Hours have at least two digits.
+ * The colons are merged into the preceding digits, like the decimal point.
+ * \param msecs The duration in milliseconds.
+ * \param precision The count of decimal places of the seconds, up to maxTimePrecision. The places are truncated.
+ * \param buffer Receives the characters. The result is not terminated.
+ * \param size The size of the buffer. Should be at least timeBufferSize.
+ * \return The count of written characters or -1 when the duration is negative or the buffer is too small.
+ */
+inline int formatTime(qint64 msecs, int precision, char* buffer, int size)
+{
+	if (msecs < 0 || precision < 0 || precision > maxTimePrecision)
+		return -1;
+
+	qint64 seconds = msecs / 1000;
+	char hours[20];
+	int count = reverseDigits<10>(static_cast<quint64>(seconds / 3600), hours);
+	int length = qMax(count, 2) + 6 + (precision ? precision + 1 : 0);
+	if (length > size)
+		return -1;
+
+	char* p = buffer;
+	if (count < 2)
+		*p++ = '0';
+	while (count > 0)
+		*p++ = hours[--count];
+
+	int minutes = static_cast<int>(seconds / 60 % 60);
+	int secs = static_cast<int>(seconds % 60);
+	*p++ = ':';
+	*p++ = static_cast<char>('0' + minutes / 10);
+	*p++ = static_cast<char>('0' + minutes % 10);
+	*p++ = ':';
+	*p++ = static_cast<char>('0' + secs / 10);
+	*p++ = static_cast<char>('0' + secs % 10);
+
+	if (precision)
+	{
+		*p++ = '.';
+		int millis = static_cast<int>(msecs % 1000);
+		for (int divisor = 100; precision > 0; --precision, divisor /= 10)
+			*p++ = static_cast<char>('0' + millis / divisor % 10);
+	}
+
+	return length;
+}
+} // namespace
+
+#endif /* NUMBERFORMAT_P_HPP_ */
@@ -0,0 +1,56 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file renderstats_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef RENDERSTATS_P_HPP_
+#define RENDERSTATS_P_HPP_
+
+#include <atomic>
+
+#include <QtGlobal>
+
+/** \internal Cumulative counters of the rendering of a display.
+ * Written on the render thread (overflows on the GUI thread) and read on the GUI thread, so they are atomic. */
+struct RenderCounters
+{
+	std::atomic<qint64> paintNodeUpdates { 0 };
+	std::atomic<qint64> geometryFrames { 0 };
+	std::atomic<qint64> segmentFrames { 0 };
+	std::atomic<qint64> touchedDigits { 0 };
+	std::atomic<qint64> touchedVertices { 0 };
+	std::atomic<qint64> dirtiedMaterials { 0 };
+	std::atomic<qint64> overflows { 0 };
+	std::atomic<qint64> updateNanoseconds { 0 };
+};
+
+/* Apply a statement to the counters if collection is compiled in and enabled at runtime (counters not null).
+ * Without SSD_ENABLE_STATS the statement is not compiled at all. */
+#ifdef SSD_ENABLE_STATS
+#define SSD_STAT(counters, statement) do { if (Q_UNLIKELY(counters)) (counters)->statement; } while (0)
+#else
+#define SSD_STAT(counters, statement) do {} while (0)
+#endif
+
+#endif /* RENDERSTATS_P_HPP_ */
@@ -0,0 +1,394 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file segmentgeometry_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef SEGMENTGEOMETRY_P_HPP_
+#define SEGMENTGEOMETRY_P_HPP_
+
+#include <algorithm>
+
+#include <QtGlobal>
+#include <QMatrix>
+#include <QRectF>
+
+/* Levels of detail of the element geometries. */
+enum Detail
+{
+	DetailLow,   //!< Rectangular segments, hexagonal dot
+	DetailMedium,//!< Pointed segments, dot with 24 edges
+	DetailHigh,  //!< Pointed segments, dot with 48 edges
+};
+
+/** \internal Immutable vertex set of an element. Kept as separate x and y arrays for the transformation.
+ * The miter vectors move a vertex by a distance of 1 from every edge it belongs to; the outline lists the vertices
+ * on the boundary in order. Both are used to feather the edges. */
+template<int N>
+struct VertexPrototype
+{
+	enum { VertexCount = N };
+	float x[N];
+	float y[N];
+	float mx[N];
+	float my[N];
+	quint8 outline[N];
+	int outlineCount;
+};
+
+/** \internal Reference to the vertices of a prototype.
+ * Segments are triangle strips, the dot is a triangle fan. */
+struct ElementShape
+{
+	template<int N>
+	Q_DECL_CONSTEXPR ElementShape(const VertexPrototype<N>& prototype):
+		x(prototype.x), y(prototype.y), mx(prototype.mx), my(prototype.my), outline(prototype.outline),
+		vertexCount(N), outlineCount(prototype.outlineCount)
+	{
+	}
+
+	/** \internal Count of triangles of the shape. */
+	inline Q_DECL_CONSTEXPR int triangleCount() const { return vertexCount - 2; }
+
+	const float* x;
+	const float* y;
+	const float* mx;
+	const float* my;
+	const quint8* outline;
+	int vertexCount;
+	int outlineCount;
+};
+
+/** \internal Shapes of the elements at a level of detail. */
+struct Tessellation
+{
+	ElementShape hSegment;
+	ElementShape vSegment;
+	ElementShape dot;
+
+	/** \internal Returns the shape of a segment rotated by the given degrees (0 or 90). */
+	inline const ElementShape& segment(qreal deg) const { return deg ? vSegment : hSegment; }
+};
+
+namespace
+{
+/* Sizes in un-scaled coordinate system. */
+Q_CONSTEXPR qreal baseSegLength = 2.0;
+Q_CONSTEXPR qreal baseSegWidth = 0.60;
+Q_CONSTEXPR qreal baseSegGap = 0.45 / 10;
+Q_CONSTEXPR qreal baseDigitHeight = 2 * baseSegLength + baseSegWidth + 4 * baseSegGap;
+
+Q_CONSTEXPR qreal baseDotRadius = baseSegWidth * 0.6;
+Q_CONSTEXPR qreal baseDigitWidth = baseSegLength + baseSegWidth + 2 * baseSegGap + 2 * baseDotRadius + baseSegGap;
+
+/* Effective digit heights in device pixels at which the next higher level of detail is used. */
+Q_CONSTEXPR qreal detailMediumPixels = 24;
+Q_CONSTEXPR qreal detailHighPixels = 96;
+
+/* Segment codes of the ASCII characters. Bit 0-6 represent the segments A-G.
+ * From QLCDNumber:
+ * These digits and other symbols can be shown: 0/O, 1, 2, 3, 4, 5/S, 6, 7, 8, 9/g, minus, decimal point,
+ * A, B, C, D, E, F, h, H, L, o, P, r, u, U, Y, colon, degree sign
+ * (which is specified as single quote in the string) and space.
+ * Additionally: lowercase hex digits, G, I, J, R, i, j, l, n, p, s, t, y, underscore and equal sign.
+ * The decimal point lights the dot of the preceding digit, a colon the colon that follows it; both are handled by
+ * segmentCodes() and blank in the table. Unsupported characters are blank. */
+Q_CONSTEXPR quint8 lutAsciiSegCode[128] =
+{
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 0x00-0x0f control
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, // 0x10-0x1f control
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x63, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, // 0x20-0x2f ' '-'/'
+	0x3f, 0x06, 0x5b, 0x4f, 0x66, 0x6d, 0x7d, 0x07, 0x7f, 0x6f, 0x00, 0x00, 0x00, 0x48, 0x00, 0x00, // 0x30-0x3f '0'-'?'
+	0x00, 0x77, 0x7c, 0x39, 0x5e, 0x79, 0x71, 0x3d, 0x76, 0x06, 0x1e, 0x00, 0x38, 0x00, 0x00, 0x3f, // 0x40-0x4f '@'-'O'
+	0x73, 0x00, 0x50, 0x6d, 0x00, 0x3e, 0x00, 0x00, 0x00, 0x6e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, // 0x50-0x5f 'P'-'_'
+	0x00, 0x77, 0x7c, 0x58, 0x5e, 0x79, 0x71, 0x6f, 0x74, 0x04, 0x0e, 0x00, 0x30, 0x00, 0x54, 0x5c, // 0x60-0x6f '`'-'o'
+	0x73, 0x00, 0x50, 0x6d, 0x78, 0x1c, 0x00, 0x00, 0x00, 0x6e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00  // 0x70-0x7f 'p'-''
+};
+/* Bit of the dot in a segment code. */
+Q_CONSTEXPR quint8 dotBit = 0x80;
+/* Bit of the colon in a segment code. Segment masks have 8 bits, so only text lights the colon. */
+Q_CONSTEXPR quint16 colonBit = 0x100;
+
+/* Elements of a digit: The segments A-G, the dot and the upper and lower dot of the colon. */
+Q_CONSTEXPR int elementCount = 10;
+
+/* Rotation of the segments A-G in degrees. */
+Q_CONSTEXPR qreal segRotation[] = { 0, 90, 90, 0, 90, 90, 0 };
+
+/** \internal Returns the segment code of a Latin-1 character.
+ * The lookup is branch-free; characters outside of the ASCII range are blank. */
+inline Q_DECL_CONSTEXPR quint8 segmentCode(char c)
+{
+	return static_cast<quint8>(lutAsciiSegCode[static_cast<quint8>(c) & 0x7f] * (static_cast<quint8>(c) < 0x80));
+}
+
+/** \internal Returns the bit of a segment code that controls an element. Both dots of the colon share one bit. */
+inline Q_DECL_CONSTEXPR quint16 elementBit(int element)
+{
+	return element < 8 ? quint16(1 << element) : colonBit;
+}
+
+/** \internal Returns true if the character is a separator that is merged into the preceding digit. */
+inline Q_DECL_CONSTEXPR bool isSeparator(char c)
+{
+	return c == '.' || c == ':';
+}
+
+/** \internal Returns the bit a separator lights in the preceding digit. */
+inline Q_DECL_CONSTEXPR quint16 separatorBit(char c)
+{
+	return c == ':' ? colonBit : dotBit;
+}
+
+/** \internal Returns the count of leading characters of a text that fit into the digits.
+ * A digit takes a character and the separators following it; separators at the start take a digit of their own.
+ * Separators past the fitting characters are not counted.
+ * \param digits Receives the count of digits taken by the fitting characters.
+ */
+inline int fittingLength(const char* text, int size, int digitCount, int* digits)
+{
+	int length = 0;
+	int taken = 0;
+	for (; length < size && taken < digitCount; ++taken)
+	{
+		if (!isSeparator(text[length]))
+			++length;
+		while (length < size && isSeparator(text[length]))
+			++length;
+	}
+	*digits = taken;
+	return length;
+}
+
+/** \internal Decode Latin-1 text into one segment code per digit.
+ * The text is right justified into the digits, separators are merged into the preceding digit. If the text is too
+ * long, its leading characters are shown.
+ * \return False if the text did not fit.
+ */
+inline bool segmentCodes(const char* text, int size, quint16* codes, int digitCount)
+{
+	int digits;
+	int length = fittingLength(text, size, digitCount, &digits);
+	bool fits = length == size;
+	size = length;
+
+	int i = size - 1;
+	for (int j = digitCount - 1; j >= 0; --j, --i)
+	{
+		quint16 code = 0;
+		while (i >= 0 && isSeparator(text[i]))
+		{
+			code |= separatorBit(text[i]);
+			--i;
+		}
+
+		if (i >= 0)
+			code |= segmentCode(text[i]);
+		codes[j] = code;
+	}
+	return fits;
+}
+
+/* Compile time generation of the prototypes. C++11 constexpr functions consist of a single return statement, so
+ * the arrays are expanded from an index pack and sine/cosine are evaluated as recursive Taylor series. */
+template<int... I> struct Indices {};
+template<int N, int... I> struct MakeIndices: MakeIndices < N - 1, N - 1, I... > {};
+template<int... I> struct MakeIndices<0, I...> { typedef Indices<I...> Type; };
+
+Q_CONSTEXPR double pi = 3.14159265358979323846;
+
+inline Q_DECL_CONSTEXPR double sinSeries(double x, double term, int n)
+{
+	return n > 41 ? 0 : term + sinSeries(x, -term * x * x / ((n + 1) * (n + 2)), n + 2);
+}
+/** \internal Compile time sine of an angle in degrees. */
+inline Q_DECL_CONSTEXPR double constSin(double deg)
+{
+	return deg > 180 ? constSin(deg - 360) : sinSeries(deg * pi / 180, deg * pi / 180, 1);
+}
+/** \internal Compile time cosine of an angle in degrees. */
+inline Q_DECL_CONSTEXPR double constCos(double deg)
+{
+	return constSin(deg + 90);
+}
+
+/* Vertices of the horizontal segment. They are placed in the center of a 2-dimensional coordinate system to
+ * simplify the rotation. The y values are increasing downwards to ease mapping to Quicks coordinate system.
+ *   /v2---------v4\
+ * v0               v5
+ *   \v1---------v3/
+ * */
+inline Q_DECL_CONSTEXPR double segmentX(int i)
+{
+	return i == 0 ? -baseSegLength / 2 : i == 5 ? baseSegLength / 2
+	       : i < 3 ? -baseSegLength / 2 + baseSegWidth / 2 : baseSegLength / 2 - baseSegWidth / 2;
+}
+inline Q_DECL_CONSTEXPR double segmentY(int i)
+{
+	return (i == 0 || i == 5) ? 0 : (i & 1) ? baseSegWidth / 2 : -baseSegWidth / 2;
+}
+
+/* Miter vectors of the segment vertices. The tips have a right angle, the sides meet the tip edges at 135 degrees.
+ * The simplified segment is a rectangle. */
+Q_CONSTEXPR double sqrt2 = 1.41421356237309504880;
+inline Q_DECL_CONSTEXPR double segmentMiterX(int i, bool pointed)
+{
+	return i == 0 ? -sqrt2 : i == 5 ? sqrt2 : (i < 3 ? -1 : 1) * (pointed ? sqrt2 - 1 : 1);
+}
+inline Q_DECL_CONSTEXPR double segmentMiterY(int i)
+{
+	return (i == 0 || i == 5) ? 0 : (i & 1) ? 1 : -1;
+}
+
+/** \internal Returns the k-th outline vertex of a triangle strip with n vertices zigzagging along a convex shape:
+ * The first vertex, the odd ones ascending and the even ones descending. */
+inline Q_DECL_CONSTEXPR int stripOutline(int k, int n)
+{
+	return k == 0 ? 0 : 2 * k - 1 < n ? 2 * k - 1 : 2 * (n - k);
+}
+
+/* Vertices of the dot as triangle fan: The center followed by segs + 1 points on the circle. */
+inline Q_DECL_CONSTEXPR double dotX(int i, int segs)
+{
+	return i ? baseDotRadius * constCos((i - 1) * 360.0 / segs) : 0;
+}
+inline Q_DECL_CONSTEXPR double dotY(int i, int segs)
+{
+	return i ? baseDotRadius * constSin((i - 1) * 360.0 / segs) : 0;
+}
+/* The miter of a regular polygon is radial and longer by the inverse cosine of half the central angle. */
+inline Q_DECL_CONSTEXPR double dotMiterX(int i, int segs)
+{
+	return i ? constCos((i - 1) * 360.0 / segs) / constCos(180.0 / segs) : 0;
+}
+inline Q_DECL_CONSTEXPR double dotMiterY(int i, int segs)
+{
+	return i ? constSin((i - 1) * 360.0 / segs) / constCos(180.0 / segs) : 0;
+}
+
+/* The segment generators take the indices 0..n-1 and the index of the first vertex of the full segment. */
+template<int... I>
+inline Q_DECL_CONSTEXPR VertexPrototype<sizeof...(I)> makeHSegment(Indices<I...>, int first)
+{
+	return VertexPrototype<sizeof...(I)>
+	{
+		{ float(segmentX(I + first))... }, { float(segmentY(I + first))... },
+		{ float(segmentMiterX(I + first, sizeof...(I) == 6))... }, { float(segmentMiterY(I + first))... },
+		{ quint8(stripOutline(I, sizeof...(I)))... }, sizeof...(I)
+	};
+}
+/* Rotated by 90 degrees: (x, y) -> (-y, x) */
+template<int... I>
+inline Q_DECL_CONSTEXPR VertexPrototype<sizeof...(I)> makeVSegment(Indices<I...>, int first)
+{
+	return VertexPrototype<sizeof...(I)>
+	{
+		{ float(-segmentY(I + first))... }, { float(segmentX(I + first))... },
+		{ float(-segmentMiterY(I + first))... }, { float(segmentMiterX(I + first, sizeof...(I) == 6))... },
+		{ quint8(stripOutline(I, sizeof...(I)))... }, sizeof...(I)
+	};
+}
+/* The last point of the fan closes the circle, so it is no separate outline vertex. */
+template<int... I>
+inline Q_DECL_CONSTEXPR VertexPrototype<sizeof...(I)> makeDot(Indices<I...>)
+{
+	return VertexPrototype < sizeof...(I) >
+	{
+		{ float(dotX(I, sizeof...(I) - 2))... }, { float(dotY(I, sizeof...(I) - 2))... },
+		{ float(dotMiterX(I, sizeof...(I) - 2))... }, { float(dotMiterY(I, sizeof...(I) - 2))... },
+		{ quint8(I + 1)... }, sizeof...(I) - 2
+	};
+}
+
+/* The prototypes shared by all elements. The simplified segment is the rectangle v1-v4 of the full one. */
+Q_CONSTEXPR VertexPrototype<6> hSegmentPrototype = makeHSegment(MakeIndices<6>::Type(), 0);
+Q_CONSTEXPR VertexPrototype<6> vSegmentPrototype = makeVSegment(MakeIndices<6>::Type(), 0);
+Q_CONSTEXPR VertexPrototype<4> hSegmentLowPrototype = makeHSegment(MakeIndices<4>::Type(), 1);
+Q_CONSTEXPR VertexPrototype<4> vSegmentLowPrototype = makeVSegment(MakeIndices<4>::Type(), 1);
+Q_CONSTEXPR VertexPrototype<6 + 2> dotLowPrototype = makeDot(MakeIndices<6 + 2>::Type());
+Q_CONSTEXPR VertexPrototype<24 + 2> dotPrototype = makeDot(MakeIndices<24 + 2>::Type());
+Q_CONSTEXPR VertexPrototype<48 + 2> dotHighPrototype = makeDot(MakeIndices<48 + 2>::Type());
+
+/** \internal Returns the shapes of the elements at the given level of detail. */
+inline const Tessellation& tessellation(Detail detail)
+{
+	static const Tessellation levels[] =
+	{
+		{ hSegmentLowPrototype, vSegmentLowPrototype, dotLowPrototype },
+		{ hSegmentPrototype, vSegmentPrototype, dotPrototype },
+		{ hSegmentPrototype, vSegmentPrototype, dotHighPrototype }
+	};
+	return levels[detail];
+}
+
+/** \internal Returns the level of detail for a digit height in device pixels. */
+inline Q_DECL_CONSTEXPR Detail detailForPixelSize(qreal pixels)
+{
+	return pixels < detailMediumPixels ? DetailLow : pixels < detailHighPixels ? DetailMedium : DetailHigh;
+}
+
+/** \internal Calculate the transformations of all elements of a digit.
+ * \param rectangle A rectangle in which to layout the digit.
+ * \param scale The factor to adjust the basic segment sizes.
+ * \param mats Array of elementCount matrices that receives the transformations of the segments A-G followed by the
+ * dot and the upper and lower dot of the colon.
+ */
+inline void digitTransforms(const QRectF& rectangle, qreal scale, QMatrix* mats)
+{
+	qreal segWidth = baseSegWidth * scale;
+	qreal segLength = baseSegLength * scale;
+	qreal segGap = baseSegGap * scale;
+	qreal dotRadius = baseDotRadius * scale;
+
+	/* Segments are positioned around the center of the digit, excluding the dot.
+	 * So the digit center must be left justified by the half of the space the dot needs. */
+	qreal digitCenterX = rectangle.center().x() - (2 * dotRadius + segGap) / 2;
+	qreal digitCenterY = rectangle.center().y();
+
+	// QMatrix(qreal m11, qreal m12, qreal m21, qreal m22, qreal dx, qreal dy)
+	// ->       hScaling, vShearing, hShearing,  vScaling,   hTrans,   vTrans
+
+	// (A) top
+	mats[0] = QMatrix(scale, 0, 0, scale, digitCenterX, digitCenterY - segLength - segGap * 2);
+	// (B) top right
+	mats[1] = QMatrix(scale, 0, 0, scale, digitCenterX + segLength / 2 + segGap, digitCenterY - segLength / 2 - segGap);
+	// (C) bottom right
+	mats[2] = QMatrix(scale, 0, 0, scale, digitCenterX + segLength / 2 + segGap, digitCenterY + segLength / 2 + segGap);
+	// (D) bottom
+	mats[3] = QMatrix(scale, 0, 0, scale, digitCenterX, digitCenterY + segLength + segGap * 2);
+	// (E) bottom left
+	mats[4] = QMatrix(scale, 0, 0, scale, digitCenterX - segLength / 2 - segGap, digitCenterY + segLength / 2 + segGap);
+	// (F) top left
+	mats[5] = QMatrix(scale, 0, 0, scale, digitCenterX - segLength / 2 - segGap, digitCenterY - segLength / 2 - segGap);
+	// (G) middle
+	mats[6] = QMatrix(scale, 0, 0, scale, digitCenterX, digitCenterY);
+
+	// The dot is always laid out. Appearance is controlled by color.
+	qreal dotX = digitCenterX + segLength / 2 + segGap + segWidth / 2 + dotRadius + segGap;
+	mats[7] = QMatrix(scale, 0, 0, scale, dotX, digitCenterY + segLength + 2 * segGap + segWidth / 2 - dotRadius);
+	// The colon shares the column of the dot, between this digit and the next, centered on the halves of the digit
+	mats[8] = QMatrix(scale, 0, 0, scale, dotX, digitCenterY - segLength / 2 - segGap);
+	mats[9] = QMatrix(scale, 0, 0, scale, dotX, digitCenterY + segLength / 2 + segGap);
+}
+} // namespace
+
+#endif /* SEGMENTGEOMETRY_P_HPP_ */
@@ -0,0 +1,311 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file segmentshader_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef SEGMENTSHADER_P_HPP_
+#define SEGMENTSHADER_P_HPP_
+
+#include "batchnode_p.hpp"
+
+#include <QSGMaterial>
+#include <QOpenGLShaderProgram>
+
+/** \internal Material that evaluates the segment shapes of a digit analytically in the fragment shader.
+ * The colors are uniforms. The segment code of each digit is passed as vertex attribute. */
+class SegmentMaterial: public QSGMaterial
+{
+public:
+	SegmentMaterial()
+	{
+		setFlag(Blending);
+	}
+
+	QSGMaterialType* type() const
+	{
+		static QSGMaterialType type;
+		return &type;
+	}
+
+	QSGMaterialShader* createShader() const;
+
+	int compare(const QSGMaterial* other) const
+	{
+		const SegmentMaterial* o = static_cast<const SegmentMaterial*>(other);
+		if (mOnColor.rgba() != o->mOnColor.rgba())
+			return mOnColor.rgba() < o->mOnColor.rgba() ? -1 : 1;
+		if (mOffColor.rgba() != o->mOffColor.rgba())
+			return mOffColor.rgba() < o->mOffColor.rgba() ? -1 : 1;
+		if (mFeather != o->mFeather)
+			return mFeather < o->mFeather ? -1 : 1;
+		return 0;
+	}
+
+	QColor mOnColor;
+	QColor mOffColor;
+	/* Width of the anti-aliased edges in un-scaled coordinates; 0 renders hard edges. */
+	float mFeather = 0;
+};
+
+/** \internal Shader of the SegmentMaterial. */
+class SegmentMaterialShader: public QSGMaterialShader
+{
+public:
+	const char* const* attributeNames() const
+	{
+		static const char* const names[] = { "aVertex", "aLocal", "aCode", 0 };
+		return names;
+	}
+
+	void updateState(const RenderState& state, QSGMaterial* newMaterial, QSGMaterial* oldMaterial)
+	{
+		if (state.isMatrixDirty())
+			program()->setUniformValue(mMatrixId, state.combinedMatrix());
+		if (state.isOpacityDirty())
+			program()->setUniformValue(mOpacityId, state.opacity());
+
+		// The base sizes are shared by all materials of this type
+		if (!oldMaterial)
+			program()->setUniformValue(mSizesId, static_cast<GLfloat>(baseSegLength), static_cast<GLfloat>(baseSegWidth),
+			                           static_cast<GLfloat>(baseSegGap), static_cast<GLfloat>(baseDotRadius));
+
+		SegmentMaterial* m = static_cast<SegmentMaterial*>(newMaterial);
+		SegmentMaterial* o = static_cast<SegmentMaterial*>(oldMaterial);
+		if (!o || m->compare(o) != 0)
+		{
+			program()->setUniformValue(mOnColorId, m->mOnColor);
+			program()->setUniformValue(mOffColorId, m->mOffColor);
+			// A minimal width keeps the coverage ramp defined for hard edges
+			program()->setUniformValue(mFeatherId, static_cast<GLfloat>(qMax(m->mFeather, 1e-4f)));
+		}
+	}
+
+protected:
+	void initialize()
+	{
+		mMatrixId = program()->uniformLocation("qt_Matrix");
+		mOpacityId = program()->uniformLocation("qt_Opacity");
+		mSizesId = program()->uniformLocation("sizes");
+		mOnColorId = program()->uniformLocation("onColor");
+		mOffColorId = program()->uniformLocation("offColor");
+		mFeatherId = program()->uniformLocation("feather");
+	}
+
+	const char* vertexShader() const
+	{
+		return
+		    "uniform highp mat4 qt_Matrix;                                      \n"
+		    "attribute highp vec4 aVertex;                                      \n"
+		    "attribute highp vec2 aLocal;                                       \n"
+		    "attribute highp float aCode;                                       \n"
+		    "varying highp vec2 vLocal;                                         \n"
+		    "varying highp float vCode;                                         \n"
+		    "void main() {                                                      \n"
+		    "    vLocal = aLocal;                                               \n"
+		    "    vCode = aCode;                                                 \n"
+		    "    gl_Position = qt_Matrix * aVertex;                             \n"
+		    "}";
+	}
+
+	/* Coordinates are un-scaled and relative to the digit center (see digitTransforms()).
+	 * Each shape yields its coverage from the distance to its edges, ramped over the feather width. The colon only
+	 * covers while it is on.
+	 * GLSL ES 1.0 has no bit operations, so the code bits are extracted arithmetically. */
+	const char* fragmentShader() const
+	{
+		return
+		    "uniform lowp float qt_Opacity;                                     \n"
+		    "uniform lowp vec4 onColor;                                         \n"
+		    "uniform lowp vec4 offColor;                                        \n"
+		    "uniform highp vec4 sizes; // length, width, gap, dot radius        \n"
+		    "uniform highp float feather;                                       \n"
+		    "varying highp vec2 vLocal;                                         \n"
+		    "varying highp float vCode;                                         \n"
+		    "highp float cover(highp float d) {                                 \n"
+		    "    return clamp(d / feather + 0.5, 0.0, 1.0);                     \n"
+		    "}                                                                  \n"
+		    "highp float hSeg(highp vec2 p) {                                   \n"
+		    "    p = abs(p);                                                    \n"
+		    "    return cover(sizes.y / 2.0 - p.y)                              \n"
+		    "         * cover((sizes.x / 2.0 - p.x - p.y) * 0.70710678);        \n"
+		    "}                                                                  \n"
+		    "highp float vSeg(highp vec2 p) { return hSeg(p.yx); }              \n"
+		    "highp float bit(highp float n) {                                   \n"
+		    "    return mod(floor(vCode / exp2(n)), 2.0);                       \n"
+		    "}                                                                  \n"
+		    "void main() {                                                      \n"
+		    "    highp float l = sizes.x;                                       \n"
+		    "    highp float g = sizes.z;                                       \n"
+		    "    highp float r = sizes.w;                                       \n"
+		    "    highp vec2 p = vLocal;                                         \n"
+		    "    highp float s[8];                                              \n"
+		    "    s[0] = hSeg(p - vec2(0.0, -l - 2.0 * g));                      \n"
+		    "    s[1] = vSeg(p - vec2(l / 2.0 + g, -l / 2.0 - g));              \n"
+		    "    s[2] = vSeg(p - vec2(l / 2.0 + g, l / 2.0 + g));               \n"
+		    "    s[3] = hSeg(p - vec2(0.0, l + 2.0 * g));                       \n"
+		    "    s[4] = vSeg(p - vec2(-l / 2.0 - g, l / 2.0 + g));              \n"
+		    "    s[5] = vSeg(p - vec2(-l / 2.0 - g, -l / 2.0 - g));             \n"
+		    "    s[6] = hSeg(p);                                                \n"
+		    "    s[7] = cover(r - length(p - vec2(l / 2.0 + 2.0 * g + sizes.y / 2.0 + r, \n"
+		    "                                     l + 2.0 * g + sizes.y / 2.0 - r))); \n"
+		    "    highp float cx = l / 2.0 + 2.0 * g + sizes.y / 2.0 + r;        \n"
+		    "    highp float colon = bit(8.0) * (cover(r - length(p - vec2(cx, -l / 2.0 - g))) \n"
+		    "                                  + cover(r - length(p - vec2(cx, l / 2.0 + g)))); \n"
+		    "    highp float inside = colon;                                    \n"
+		    "    highp float on = colon;                                        \n"
+		    "    for (int i = 0; i < 8; ++i) {                                  \n"
+		    "        inside += s[i];                                            \n"
+		    "        on += s[i] * bit(float(i));                                \n"
+		    "    }                                                              \n"
+		    "    lowp vec4 c = mix(offColor, onColor, on / max(inside, 1e-4));  \n"
+		    "    lowp float a = c.a * min(inside, 1.0) * qt_Opacity;            \n"
+		    "    gl_FragColor = vec4(c.rgb * a, a);                             \n"
+		    "}";
+	}
+
+private:
+	int mMatrixId = -1;
+	int mOpacityId = -1;
+	int mSizesId = -1;
+	int mOnColorId = -1;
+	int mOffColorId = -1;
+	int mFeatherId = -1;
+};
+
+inline QSGMaterialShader* SegmentMaterial::createShader() const
+{
+	return new SegmentMaterialShader;
+}
+
+/** \internal Batch node that draws every digit as a single quad shaded by the SegmentMaterial.
+ * A value update only rewrites the code attribute of the changed digits. */
+class ShaderNode: public BatchNode
+{
+public:
+	/* Two triangles per digit. */
+	enum { DigitVertices = 6 };
+
+	/** \internal Vertex layout: position, un-scaled coordinate relative to the digit center and segment code. */
+	struct Vertex
+	{
+		float x, y;
+		float u, v;
+		float code;
+	};
+
+	ShaderNode():
+		mGeometry(attributes(), 0)
+	{
+		mGeometry.setDrawingMode(GL_TRIANGLES);
+		setGeometry(&mGeometry);
+		setMaterial(&mMaterial);
+	}
+
+	bool setColors(const QColor& onColor, const QColor& offColor)
+	{
+		if (onColor == mMaterial.mOnColor && offColor == mMaterial.mOffColor)
+			return false;
+
+		mMaterial.mOnColor = onColor;
+		mMaterial.mOffColor = offColor;
+		markDirty(QSGNode::DirtyMaterial);
+		return true;
+	}
+
+	void setFeather(qreal width)
+	{
+		mFeather = width;
+	}
+
+	void updateGeometry(int digit, const QRectF& rectangle, qreal scale)
+	{
+		Q_ASSERT(digit < getDigitCount());
+
+		// The shader works in un-scaled coordinates
+		float feather = static_cast<float>(mFeather / scale);
+		if (feather != mMaterial.mFeather)
+		{
+			mMaterial.mFeather = feather;
+			markDirty(QSGNode::DirtyMaterial);
+		}
+
+		// The matrix of the middle segment (G) maps from the un-scaled digit space
+		QMatrix mats[elementCount];
+		digitTransforms(rectangle, scale, mats);
+		const QPointF center(mats[6].dx(), mats[6].dy());
+
+		const QPointF corners[] = { rectangle.topLeft(), rectangle.bottomLeft(), rectangle.topRight(),
+		                            rectangle.bottomLeft(), rectangle.topRight(), rectangle.bottomRight()
+		                          };
+
+		Vertex* v = static_cast<Vertex*>(mGeometry.vertexData()) + digit * DigitVertices;
+		for (const QPointF& c : corners)
+		{
+			v->x = static_cast<float>(c.x());
+			v->y = static_cast<float>(c.y());
+			v->u = static_cast<float>((c.x() - center.x()) / scale);
+			v->v = static_cast<float>((c.y() - center.y()) / scale);
+			++v;
+		}
+
+		markDirty(QSGNode::DirtyGeometry);
+	}
+
+	qint64 memoryUsage() const
+	{
+		return sizeof(ShaderNode) + geometryMemoryUsage(mGeometry);
+	}
+
+protected:
+	void allocate(int digitCount)
+	{
+		mGeometry.allocate(digitCount * DigitVertices);
+	}
+
+	int writeCode(int digit, quint16 code, quint16 /*flipped*/)
+	{
+		Vertex* v = static_cast<Vertex*>(mGeometry.vertexData()) + digit * DigitVertices;
+		for (int i = 0; i < DigitVertices; ++i)
+			v[i].code = code;
+		return DigitVertices;
+	}
+
+private:
+	static const QSGGeometry::AttributeSet& attributes()
+	{
+		static const QSGGeometry::Attribute attr[] =
+		{
+			QSGGeometry::Attribute::create(0, 2, GL_FLOAT, true),
+			QSGGeometry::Attribute::create(1, 2, GL_FLOAT),
+			QSGGeometry::Attribute::create(2, 1, GL_FLOAT)
+		};
+		static const QSGGeometry::AttributeSet set = { 3, sizeof(Vertex), attr };
+		return set;
+	}
+
+	QSGGeometry mGeometry;
+	SegmentMaterial mMaterial;
+	qreal mFeather = 0;
+};
+
+#endif /* SEGMENTSHADER_P_HPP_ */
@@ -24,75 +24,52 @@
  */
 
 #include <gui/sevensegmentdisplay.hpp>
-#include <gui/displaynode_p.hpp>
+#include <gui/sevensegmentdisplay_p.hpp>
 
-class SevenSegmentDisplayPrivate
+#include <QVarLengthArray>
+
+SevenSegmentDisplay::SevenSegmentDisplay(QQuickItem* parent) :
+	QQuickItem(parent), d_ptr(new SevenSegmentDisplayPrivate(this))
 {
-public:
-	SevenSegmentDisplayPrivate():
-		mDisplayNode(new DisplayNode)
-	{
-	}
-	Q_DISABLE_COPY(SevenSegmentDisplayPrivate)
+	setFlag(ItemHasContents, true);
 
-	bool display(QVariant v)
+	Q_D(SevenSegmentDisplay);
+	d->mRateTimer.setSingleShot(true);
+	connect(&d->mRateTimer, &QTimer::timeout, this, [this]()
 	{
-		bool updateNeeded = false;
-
-		mCurrentValue = v;
-
-		// Update value
-		switch (v.type())
+		Q_D(SevenSegmentDisplay);
+		// Keep limiting as long as values arrive
+		if (d->mAccumulator.count)
 		{
-		case QVariant::Double:
-		{
-			QString s;
-
-			/* NOTE: In no case does a nonexistent or small field width cause truncation of a field; if the result of a con‐
-			 * version is wider than the field width, the field is expanded to contain the conversion result. */
-			if (mPrecision > 0)
-				s.sprintf("%*.*f", mDisplayNode->getDigitCount() + 1 - mPrecision, mPrecision, v.toDouble());
-			else
-				s.sprintf("%*.0f", mDisplayNode->getDigitCount(), v.toDouble());
-
-			updateNeeded =  mDisplayNode->setString(s);
+			flushCoalesced();
+			d->mRateTimer.start();
 		}
-		break;
-		case QVariant::String:
-			updateNeeded =  mDisplayNode->setString(v.toString());
-			break;
-		default:
-			qWarning() << "BUG: Unhandled type in mCurrentValue: (" << v.typeName() << ")";
-			break;
-		}
-
-		return updateNeeded;
-	}
-
-	DisplayNode* mDisplayNode; // Owned by scene graph
-	QVariant mCurrentValue;
-	int mPrecision = 0;
-};
-
-SevenSegmentDisplay::SevenSegmentDisplay(QQuickItem* parent) :
-	QQuickItem(parent), d_ptr(new SevenSegmentDisplayPrivate())
-{
-	setFlag(ItemHasContents, true);
+	});
+	// The antialiasing property of QQuickItem switches to feathered element edges
+	connect(this, &QQuickItem::antialiasingChanged, this, [this](bool antialiasing)
+	{
+		Q_D(SevenSegmentDisplay);
+		if (d->assign(d->mAntialiasing, antialiasing, SevenSegmentDisplayPrivate::DirtyAntialiasing))
+			update();
+	});
 	//	connect(this, &QQuickItem::widthChanged, this, [&]() { qDebug() << "width:" << width(); });
 	//	connect(this, &QQuickItem::heightChanged, this, [&]() { qDebug() << "height:" << height(); });
 }
 
 SevenSegmentDisplay::~SevenSegmentDisplay()
 {
+	Q_D(SevenSegmentDisplay);
+	if (d->mFeed)
+		d->mFeed->detach();
 }
 
-int SevenSegmentDisplay::getDigitCount() const { Q_D(const SevenSegmentDisplay); return d->mDisplayNode->getDigitCount(); }
+int SevenSegmentDisplay::getDigitCount() const { Q_D(const SevenSegmentDisplay); return d->mText.getDigitCount(); }
 void SevenSegmentDisplay::setDigitCount(int count)
 {
 	Q_D(SevenSegmentDisplay);
 	if (count < 0)
 		qWarning() << "Digit count cannot be negative";
-	else if (d->mDisplayNode->setDigitCount(count))
+	else if (d->setDigitCount(count))
 	{
 		update();
 		emit digitCountChanged();
@@ -102,37 +79,181 @@ void SevenSegmentDisplay::setDigitCount(int count)
 	}
 }
 
-double SevenSegmentDisplay::getValue() const
+double SevenSegmentDisplay::getValue() const { Q_D(const SevenSegmentDisplay); return d->mValue; }
+void SevenSegmentDisplay::setValue(double value)
 {
-	Q_D(const SevenSegmentDisplay);
-	bool ok = false;
-	double result = d->mDisplayNode->getString().toDouble(&ok);
-	if (ok)
-		return result;
-	else
-		return 0;
+	Q_D(SevenSegmentDisplay);
+	SSD_TRACE(d->traceValue());
+	d->stopAnimation();
+	if (d->mCoalesce != CoalesceNone)
+	{
+		// Formatting and notification are deferred to the end of the update interval
+		if (d->accumulate(value))
+		{
+			if (!d->mMaxUpdateRate)
+				polish();
+			else if (!d->mRateTimer.isActive())
+			{
+				flushCoalesced();
+				d->mRateTimer.start();
+			}
+		}
+		return;
+	}
+
+	if (d->display(value))
+	{
+		update();
+		SSD_TRACE_SPAN("valueChanged", d->mTraceId);
+		emit valueChanged();
+	}
 }
-void SevenSegmentDisplay::setValue(double value)
+
+void SevenSegmentDisplay::animateTo(double value, int duration, int easing)
 {
 	Q_D(SevenSegmentDisplay);
-	if (d->display(QVariant(value)))
+	if (duration <= 0)
+	{
+		setValue(value);
+		return;
+	}
+
+	if (d->mAccumulator.count)
+	{
+		d->discard();
+		emit droppedValueCountChanged();
+	}
+	d->animate(value, duration, QEasingCurve(static_cast<QEasingCurve::Type>(easing)));
+	update();
+}
+
+void SevenSegmentDisplay::setInteger(qint64 value)
+{
+	Q_D(SevenSegmentDisplay);
+	SSD_TRACE(d->traceValue());
+	d->stopAnimation();
+	if (d->mAccumulator.count)
+	{
+		d->discard();
+		emit droppedValueCountChanged();
+	}
+	if (d->displayInteger(value))
+	{
+		update();
+		SSD_TRACE_SPAN("valueChanged", d->mTraceId);
+		emit valueChanged();
+	}
+}
+
+void SevenSegmentDisplay::setFixedPoint(qint64 mantissa, int exponent)
+{
+	Q_D(SevenSegmentDisplay);
+	if (qAbs(exponent) > maxFixedPointExponent)
+	{
+		qWarning() << "Exponent out of range:" << exponent;
+		return;
+	}
+
+	SSD_TRACE(d->traceValue());
+	d->stopAnimation();
+	if (d->mAccumulator.count)
+	{
+		d->discard();
+		emit droppedValueCountChanged();
+	}
+	if (d->displayFixedPoint(mantissa, exponent))
 	{
 		update();
+		SSD_TRACE_SPAN("valueChanged", d->mTraceId);
 		emit valueChanged();
 	}
 }
 
-QString SevenSegmentDisplay::getString() const { Q_D(const SevenSegmentDisplay); return d->mDisplayNode->getString(); }
+QString SevenSegmentDisplay::getString() const { Q_D(const SevenSegmentDisplay); return d->mText.getString(); }
 void SevenSegmentDisplay::setString(QString string)
 {
 	Q_D(SevenSegmentDisplay);
+	SSD_TRACE(d->traceValue());
+	d->stopAnimation();
+	if (d->mAccumulator.count)
+	{
+		// Pending values are superseded by the string
+		d->discard();
+		emit droppedValueCountChanged();
+	}
 	if (d->display(QVariant(string)))
 	{
 		update();
+		SSD_TRACE_SPAN("stringChanged", d->mTraceId);
 		emit stringChanged();
 	}
 }
 
+QByteArray SevenSegmentDisplay::getSegments() const
+{
+	Q_D(const SevenSegmentDisplay);
+	int count = d->mText.getDigitCount();
+	QVarLengthArray<quint16, 64> codes(count);
+	d->mText.codes(codes.data());
+	// The colon has no bit in a mask
+	QByteArray masks(count, 0);
+	for (int i = 0; i < count; ++i)
+		masks[i] = static_cast<char>(codes[i]);
+	return masks;
+}
+void SevenSegmentDisplay::setSegments(const QByteArray& masks)
+{
+	showSegments(masks.constData(), masks.size());
+}
+
+void SevenSegmentDisplay::setSegments(const QVector<SevenSegmentDisplay*>& displays, const QByteArray& masks)
+{
+	int offset = 0;
+	for (SevenSegmentDisplay* display : displays)
+		offset += display->takeSegments(masks, offset);
+}
+
+void SevenSegmentDisplay::setSegmentsOf(const QVariantList& displays, const QByteArray& masks)
+{
+	int offset = 0;
+	for (const QVariant& v : displays)
+	{
+		SevenSegmentDisplay* display = qobject_cast<SevenSegmentDisplay*>(v.value<QObject*>());
+		if (display)
+			offset += display->takeSegments(masks, offset);
+		else
+			qWarning() << "Not a SevenSegmentDisplay:" << v;
+	}
+}
+
+/** \internal Show the masks of a bulk update that start at offset. Returns the count of digits taken. */
+int SevenSegmentDisplay::takeSegments(const QByteArray& masks, int offset)
+{
+	int count = getDigitCount();
+	// Slice without a copy; the masks are copied only into the display
+	showSegments(masks.constData() + qMin(offset, masks.size()), qBound(0, masks.size() - offset, count));
+	return count;
+}
+
+void SevenSegmentDisplay::showSegments(const char* masks, int size)
+{
+	Q_D(SevenSegmentDisplay);
+	SSD_TRACE(d->traceValue());
+	d->stopAnimation();
+	if (d->mAccumulator.count)
+	{
+		// Pending values are superseded by the masks
+		d->discard();
+		emit droppedValueCountChanged();
+	}
+	if (d->displaySegments(masks, size))
+	{
+		update();
+		SSD_TRACE_SPAN("segmentsChanged", d->mTraceId);
+		emit segmentsChanged();
+	}
+}
+
 int SevenSegmentDisplay::getPrecision() const { Q_D(const SevenSegmentDisplay); return d->mPrecision; }
 void SevenSegmentDisplay::setPrecision(int precision)
 {
@@ -142,6 +263,8 @@ void SevenSegmentDisplay::setPrecision(int precision)
 	else if (d->mPrecision != precision)
 	{
 		d->mPrecision = precision;
+		d->mTime.precision = qMin(precision, maxTimePrecision);
+		d->mDirty |= SevenSegmentDisplayPrivate::DirtyTime;
 
 		emit precisionChanged();
 
@@ -151,83 +274,276 @@ void SevenSegmentDisplay::setPrecision(int precision)
 	}
 }
 
-int SevenSegmentDisplay::getDigitSize() const { Q_D(const SevenSegmentDisplay); return d->mDisplayNode->getDigitSize(); }
+int SevenSegmentDisplay::getRadix() const { Q_D(const SevenSegmentDisplay); return d->mRadix; }
+void SevenSegmentDisplay::setRadix(int radix)
+{
+	Q_D(SevenSegmentDisplay);
+	if (radix != 2 && radix != 8 && radix != 10 && radix != 16)
+		qWarning() << "Radix must be 2, 8, 10 or 16";
+	else if (d->mRadix != radix)
+	{
+		d->mRadix = radix;
+
+		emit radixChanged();
+
+		// Update value
+		if (d->display(d->mCurrentValue))
+			update();
+	}
+}
+
+int SevenSegmentDisplay::getDigitSize() const { Q_D(const SevenSegmentDisplay); return d->mDigitSize; }
 void SevenSegmentDisplay::setDigitSize(int size)
 {
 	Q_D(SevenSegmentDisplay);
-	if (d->mDisplayNode->setDigitSize(size))
+	if (d->assign(d->mDigitSize, size, SevenSegmentDisplayPrivate::DirtyDigitSize))
 	{
 		update();
 		emit digitSizeChanged();
 	}
 }
 
-SevenSegmentDisplay::Alignment SevenSegmentDisplay::getVerticalAlignment() const { Q_D(const SevenSegmentDisplay); return d->mDisplayNode->getVAlignment(); }
+SevenSegmentDisplay::Alignment SevenSegmentDisplay::getVerticalAlignment() const { Q_D(const SevenSegmentDisplay); return d->mVAlignment; }
 void SevenSegmentDisplay::setVerticalAlignment(Alignment alignment)
 {
 	Q_D(SevenSegmentDisplay);
-	if (d->mDisplayNode->setVAlignment(alignment))
+	if (d->assign(d->mVAlignment, alignment, SevenSegmentDisplayPrivate::DirtyAlignment))
 	{
 		update();
 		emit verticalAlignmentChanged();
 	}
 }
 
-SevenSegmentDisplay::Alignment SevenSegmentDisplay::getHorizontalAlignment() const { Q_D(const SevenSegmentDisplay); return d->mDisplayNode->getHAlignment(); }
+SevenSegmentDisplay::Alignment SevenSegmentDisplay::getHorizontalAlignment() const { Q_D(const SevenSegmentDisplay); return d->mHAlignment; }
 void SevenSegmentDisplay::setHorizontalAlignment(Alignment alignment)
 {
 	Q_D(SevenSegmentDisplay);
-	if (d->mDisplayNode->setHAlignment(alignment))
+	if (d->assign(d->mHAlignment, alignment, SevenSegmentDisplayPrivate::DirtyAlignment))
 	{
 		update();
 		emit horizontalAlignmentChanged();
 	}
 }
 
-QColor SevenSegmentDisplay::getBgColor() const { Q_D(const SevenSegmentDisplay); return d->mDisplayNode->getBgColor(); }
+SevenSegmentDisplay::RenderMode SevenSegmentDisplay::getRenderMode() const { Q_D(const SevenSegmentDisplay); return d->mRenderMode; }
+void SevenSegmentDisplay::setRenderMode(RenderMode mode)
+{
+	Q_D(SevenSegmentDisplay);
+	if (d->assign(d->mRenderMode, mode, SevenSegmentDisplayPrivate::DirtyRenderMode))
+	{
+		update();
+		emit renderModeChanged();
+	}
+}
+
+SevenSegmentDisplay::Mode SevenSegmentDisplay::getMode() const { Q_D(const SevenSegmentDisplay); return d->mTime.mode; }
+void SevenSegmentDisplay::setMode(Mode mode)
+{
+	Q_D(SevenSegmentDisplay);
+	if (d->mTime.mode != mode)
+	{
+		d->mTime.mode = mode;
+		// The value is shown again when leaving the time modes
+		d->mDirty |= SevenSegmentDisplayPrivate::DirtyTime | SevenSegmentDisplayPrivate::DirtyText;
+		update();
+		emit modeChanged();
+	}
+}
+
+bool SevenSegmentDisplay::isRunning() const { Q_D(const SevenSegmentDisplay); return d->mTime.running; }
+void SevenSegmentDisplay::setRunning(bool running)
+{
+	Q_D(SevenSegmentDisplay);
+	if (d->mTime.running != running)
+	{
+		d->mTime.setRunning(running, monotonicMsecs());
+		d->mDirty |= SevenSegmentDisplayPrivate::DirtyTime;
+		update();
+		emit runningChanged();
+	}
+}
+
+int SevenSegmentDisplay::getCountdown() const { Q_D(const SevenSegmentDisplay); return static_cast<int>(d->mTime.countdown); }
+void SevenSegmentDisplay::setCountdown(int msecs)
+{
+	Q_D(SevenSegmentDisplay);
+	if (msecs < 0)
+		qWarning() << "Countdown cannot be negative";
+	else if (d->mTime.countdown != msecs)
+	{
+		d->mTime.countdown = msecs;
+		d->mDirty |= SevenSegmentDisplayPrivate::DirtyTime;
+		update();
+		emit countdownChanged();
+	}
+}
+
+void SevenSegmentDisplay::restart()
+{
+	Q_D(SevenSegmentDisplay);
+	d->mTime.restart(monotonicMsecs());
+	d->mDirty |= SevenSegmentDisplayPrivate::DirtyTime;
+	update();
+}
+
+qint64 SevenSegmentDisplay::getElapsed() const
+{
+	Q_D(const SevenSegmentDisplay);
+	return d->mTime.elapsedAt(monotonicMsecs());
+}
+
+SevenSegmentDisplay::Coalesce SevenSegmentDisplay::getCoalesce() const { Q_D(const SevenSegmentDisplay); return d->mCoalesce; }
+void SevenSegmentDisplay::setCoalesce(Coalesce coalesce)
+{
+	Q_D(SevenSegmentDisplay);
+	if (d->mCoalesce != coalesce)
+	{
+		// Show what was combined so far with the previous mode
+		flushCoalesced();
+		d->mCoalesce = coalesce;
+		emit coalesceChanged();
+	}
+}
+
+int SevenSegmentDisplay::getMaxUpdateRate() const { Q_D(const SevenSegmentDisplay); return d->mMaxUpdateRate; }
+void SevenSegmentDisplay::setMaxUpdateRate(int rate)
+{
+	Q_D(SevenSegmentDisplay);
+	if (rate < 0)
+		qWarning() << "Update rate cannot be negative";
+	else if (d->mMaxUpdateRate != rate)
+	{
+		d->mMaxUpdateRate = rate;
+		if (rate)
+			d->mRateTimer.setInterval(qMax(1, 1000 / rate));
+		else
+			d->mRateTimer.stop();
+		flushCoalesced();
+		emit maxUpdateRateChanged();
+	}
+}
+
+qint64 SevenSegmentDisplay::getDroppedValueCount() const { Q_D(const SevenSegmentDisplay); return d->mDroppedValueCount; }
+
+/** \internal Show the combined value of the current update interval and notify about it. */
+void SevenSegmentDisplay::flushCoalesced()
+{
+	Q_D(SevenSegmentDisplay);
+	qint64 dropped = d->mDroppedValueCount;
+	if (d->flush())
+	{
+		update();
+		emit valueChanged();
+	}
+	if (d->mDroppedValueCount != dropped)
+		emit droppedValueCountChanged();
+}
+
+/** \internal Called on GUI thread before the next frame is synchronized. */
+void SevenSegmentDisplay::updatePolish()
+{
+	flushCoalesced();
+}
+
+QColor SevenSegmentDisplay::getBgColor() const { Q_D(const SevenSegmentDisplay); return d->mBgColor; }
 void SevenSegmentDisplay::setBgColor(const QColor& color)
 {
 	Q_D(SevenSegmentDisplay);
-	if (d->mDisplayNode->setBgColor(color))
+	if (d->assign(d->mBgColor, color, SevenSegmentDisplayPrivate::DirtyColors))
 	{
 		update();
 		emit bgColorChanged();
 	}
 }
 
-QColor SevenSegmentDisplay::getOnColor() const { Q_D(const SevenSegmentDisplay); return d->mDisplayNode->getOnColor(); }
+QColor SevenSegmentDisplay::getOnColor() const { Q_D(const SevenSegmentDisplay); return d->mOnColor; }
 void SevenSegmentDisplay::setOnColor(const QColor& color)
 {
 	Q_D(SevenSegmentDisplay);
-	if (d->mDisplayNode->setOnColor(color))
+	if (d->assign(d->mOnColor, color, SevenSegmentDisplayPrivate::DirtyColors))
 	{
 		update();
 		emit onColorChanged();
 	}
 }
 
-QColor SevenSegmentDisplay::getOffColor() const { Q_D(const SevenSegmentDisplay); return d->mDisplayNode->getOffColor(); }
+QColor SevenSegmentDisplay::getOffColor() const { Q_D(const SevenSegmentDisplay); return d->mOffColor; }
 void SevenSegmentDisplay::setOffColor(const QColor& color)
 {
 	Q_D(SevenSegmentDisplay);
-	if (d->mDisplayNode->setOffColor(color))
+	if (d->assign(d->mOffColor, color, SevenSegmentDisplayPrivate::DirtyColors))
 	{
 		update();
 		emit offColorChanged();
 	}
 }
 
+qint64 SevenSegmentDisplay::getMemoryUsage() const { Q_D(const SevenSegmentDisplay); return d->mMemoryUsage; }
+
+SevenSegmentStats* SevenSegmentDisplay::getStats() const
+{
+	Q_D(const SevenSegmentDisplay);
+	if (!d->mStats)
+		d->mStats = new SevenSegmentStats(const_cast<SevenSegmentDisplay*>(this));
+	return d->mStats;
+}
+
+QSharedPointer<SevenSegmentFeed> SevenSegmentDisplay::feed()
+{
+	Q_D(SevenSegmentDisplay);
+	if (!d->mFeed)
+		d->mFeed.reset(new SevenSegmentFeed(this));
+	return d->mFeed;
+}
+
 /** \internal Called on render thread when update is needed. */
 QSGNode* SevenSegmentDisplay::updatePaintNode(QSGNode* oldRoot, QQuickItem::UpdatePaintNodeData* /*d*/)
 {
 	Q_D(SevenSegmentDisplay);
+	SSD_TRACE_SPAN("sync", d->mTraceId);
 	DisplayNode* displayNode = static_cast<DisplayNode*>(oldRoot);
 	if (!displayNode)
 	{
-		displayNode = d->mDisplayNode;
-		connect(displayNode, &DisplayNode::overflow, this, &SevenSegmentDisplay::overflow);
+		displayNode = new DisplayNode;
+		displayNode->setMaterialCache(MaterialCache::forWindow(window()));
+		displayNode->setWindow(window());
+		d->mDirty = SevenSegmentDisplayPrivate::DirtyAll;
+		// The node samples the countdown on the render thread
+		connect(displayNode, &DisplayNode::countdownFinished, this, [this]()
+		{
+			Q_D(SevenSegmentDisplay);
+			if (d->mTime.running)
+			{
+				setRunning(false);
+				emit countdownFinished();
+			}
+		}, Qt::QueuedConnection);
+		// Only the end value of an animation is committed
+		connect(displayNode, &DisplayNode::animationFinished, this, [this](int serial)
+		{
+			Q_D(SevenSegmentDisplay);
+			if (!d->mAnimation.active || d->mAnimation.serial != serial)
+				return;
+
+			d->mAnimation.active = false;
+			d->mDirty |= SevenSegmentDisplayPrivate::DirtyAnimation;
+			d->display(d->mAnimation.to);
+			update();
+			emit valueChanged();
+		}, Qt::QueuedConnection);
 	}
 
+	// Statistics are switched while the GUI thread is blocked
+	RenderCounters* counters = d->mStats ? d->mStats->counters() : nullptr;
+	displayNode->setCounters(counters);
+	SSD_STAT(counters, paintNodeUpdates += 1);
+
+	d->pullFeed();
+	d->sync(displayNode);
+
+	// The level of detail depends on the size in device pixels
+	displayNode->setDevicePixelRatio(window()->effectiveDevicePixelRatio());
+
 	// Update digit and all its children
 	QSizeF contentSize = displayNode->update(boundingRect());
 #if 0
@@ -238,6 +554,13 @@ QSGNode* SevenSegmentDisplay::updatePaintNode(QSGNode* oldRoot, QQuickItem::Upda
 	// Use the returned size as implicit item sizes (imitate behavior of QQuicks Text item).
 	setImplicitWidth(contentSize.width());
 	setImplicitHeight(contentSize.height());
+	d->mMemoryUsage = displayNode->getMemoryUsage();
+
+	if (counters)
+		d->mStats->notify();
+
+	// The value is shown when the frame is swapped
+	SSD_TRACE(displayNode->traceFrame(window(), d->mTraceId); d->mTraceId = 0);
 
 	return displayNode;
 }
@@ -26,10 +26,17 @@
 #ifndef SEVENSEGMENTDISPLAY_HPP
 #define SEVENSEGMENTDISPLAY_HPP
 
+#include <gui/sevensegmentstats.hpp>
+
 #include <memory>
+#include <QEasingCurve>
 #include <QQuickItem>
+#include <QSharedPointer>
+#include <QVariant>
+#include <QVector>
 
 class SevenSegmentDisplayPrivate;
+class SevenSegmentFeed;
 
 /** QQuick widget that implements a seven-segment display. */
 class SevenSegmentDisplay : public QQuickItem
@@ -42,17 +49,39 @@ class SevenSegmentDisplay : public QQuickItem
 	/** Property that controls the current value shown by the widget. */
 	Q_PROPERTY(double value READ getValue WRITE setValue NOTIFY valueChanged)
 	Q_PROPERTY(QString string READ getString WRITE setString NOTIFY stringChanged)
+	/** Property that controls the segments directly, one mask per digit. Bit 0-6 control the segments A-G, bit 7 the
+	 * dot. Reads the masks of whatever is shown; a colon of the string has no bit and is not included. */
+	Q_PROPERTY(QByteArray segments READ getSegments WRITE setSegments NOTIFY segmentsChanged)
 
 	Q_PROPERTY(int precision READ getPrecision WRITE setPrecision NOTIFY precisionChanged)
+	/** Property that controls the radix of integers passed to setInteger(): 2, 8, 10 or 16. */
+	Q_PROPERTY(int radix READ getRadix WRITE setRadix NOTIFY radixChanged)
     /** Property that controls the digit height. */
 	Q_PROPERTY(int digitSize READ getDigitSize WRITE setDigitSize NOTIFY digitSizeChanged)
 
-	Q_ENUMS(Alignment)
+	Q_ENUMS(Alignment RenderMode Coalesce Mode)
 	/** Property that controls the vertical alignment. */
 	Q_PROPERTY(Alignment verticalAlignment READ getVerticalAlignment WRITE setVerticalAlignment NOTIFY verticalAlignmentChanged)
 	/** Property that controls the horizontal alignment. */
 	Q_PROPERTY(Alignment horizontalAlignment READ getHorizontalAlignment WRITE setHorizontalAlignment NOTIFY horizontalAlignmentChanged)
 
+	/** Property that controls how the display is rendered by the scene graph. */
+	Q_PROPERTY(RenderMode renderMode READ getRenderMode WRITE setRenderMode NOTIFY renderModeChanged)
+
+	/** Property that controls what is shown: the value or a time sampled by the render thread before each frame. */
+	Q_PROPERTY(Mode mode READ getMode WRITE setMode NOTIFY modeChanged)
+	/** Property that starts and stops the stopwatch and the countdown. */
+	Q_PROPERTY(bool running READ isRunning WRITE setRunning NOTIFY runningChanged)
+	/** Property that controls the duration of the countdown in milliseconds. */
+	Q_PROPERTY(int countdown READ getCountdown WRITE setCountdown NOTIFY countdownChanged)
+
+	/** Property that controls how values passed to setValue() are combined between two display updates. */
+	Q_PROPERTY(Coalesce coalesce READ getCoalesce WRITE setCoalesce NOTIFY coalesceChanged)
+	/** Property that limits the display updates per second when coalescing. 0 updates at most once per frame. */
+	Q_PROPERTY(int maxUpdateRate READ getMaxUpdateRate WRITE setMaxUpdateRate NOTIFY maxUpdateRateChanged)
+	/** Count of values that were combined into others instead of being shown while coalescing. */
+	Q_PROPERTY(qint64 droppedValueCount READ getDroppedValueCount NOTIFY droppedValueCountChanged)
+
 	/** Property that controls the background color. */
 	Q_PROPERTY(QColor bgColor READ getBgColor WRITE setBgColor NOTIFY bgColorChanged)
 	/** Property that controls the color of enabled segments. */
@@ -60,6 +89,9 @@ class SevenSegmentDisplay : public QQuickItem
 	/** Property that controls the color of disabled segments. */
 	Q_PROPERTY(QColor offColor READ getOffColor WRITE setOffColor NOTIFY offColorChanged)
 
+	/** Render statistics of the display. Collection is off until stats.enabled is set. */
+	Q_PROPERTY(SevenSegmentStats* stats READ getStats CONSTANT)
+
 public:
 	/** Alignment options. */
 	enum Alignment
@@ -69,21 +101,76 @@ public:
 		AlignCenter,//!< AlignCenter
 	};
 
+	/** Render modes. */
+	enum RenderMode
+	{
+		RenderSegmentNodes, //!< One geometry node and material per segment
+		RenderVertexColor,  //!< One vertex colored geometry node and material per display
+		RenderShader,       //!< One quad per digit, segments are evaluated by a fragment shader (requires OpenGL)
+		RenderAtlas,        //!< One textured quad per digit, glyphs are taken from a texture atlas shared by all displays
+	};
+
+	/** Display modes. The time modes show HH:MM:SS with precision decimal places of the seconds (at most 3).
+	 * The colons sit between the digits, so a clock needs 6 digits plus one per decimal place. */
+	enum Mode
+	{
+		ModeValue,    //!< The value, string or segments set on the display
+		ModeClock,    //!< The local time of day
+		ModeStopwatch,//!< The elapsed time while running
+		ModeCountdown,//!< The remaining time of the countdown while running
+	};
+
+	/** Coalescing modes. */
+	enum Coalesce
+	{
+		CoalesceNone,    //!< Every value is shown and notified immediately
+		CoalesceLatest,  //!< The latest value of an update interval is shown
+		CoalesceMinimum, //!< The minimum of an update interval is shown
+		CoalesceMaximum, //!< The maximum of an update interval is shown
+		CoalesceMean,    //!< The mean of an update interval is shown
+	};
+
     SevenSegmentDisplay(QQuickItem* parent = nullptr);
     virtual ~SevenSegmentDisplay();
 
     int getDigitCount() const;
     void setDigitCount(int count);
 
+    /** Returns the value last shown, without parsing the display. Strings are parsed once when they are set. */
     double getValue() const;
     void setValue(double value);
 
+    /** Count from the shown value to the given one within duration milliseconds along an easing curve, e.g.
+     * Easing.OutCubic in QML. The values in between are interpolated on the render thread before each frame; only the
+     * end value is set on the display, which emits valueChanged(). Another value ends the transition where it is. */
+    Q_INVOKABLE void animateTo(double value, int duration, int easing = QEasingCurve::Linear);
+
+    /** Display an integer in the radix. Exact over the full 64 bit range; negative values have a sign.
+     * Values pending for coalescing are superseded. */
+    Q_INVOKABLE void setInteger(qint64 value);
+    /** Display the decimal fixed point number mantissa * 10^exponent exactly, e.g. (12345, -2) as 123.45.
+     * The precision does not apply. Values pending for coalescing are superseded. */
+    Q_INVOKABLE void setFixedPoint(qint64 mantissa, int exponent);
+
     QString getString() const;
     void setString(QString string);
 
+    QByteArray getSegments() const;
+    void setSegments(const QByteArray& masks);
+    /** Show consecutive segment masks on many displays in one call, e.g. the state of a display controller.
+     * Each display takes as many masks as it has digits, in the order of the list. */
+    static void setSegments(const QVector<SevenSegmentDisplay*>& displays, const QByteArray& masks);
+    /** The bulk update for QML, e.g. display.setSegmentsOf([left, right], masks). It may be called on any display;
+     * only the listed ones are set. Named apart from setSegments() so that QML does not confuse it with the
+     * property setter. */
+    Q_INVOKABLE void setSegmentsOf(const QVariantList& displays, const QByteArray& masks);
+
     int getPrecision() const;
     void setPrecision(int precision);
 
+    int getRadix() const;
+    void setRadix(int radix);
+
     int getDigitSize() const;
     void setDigitSize(int size);
 
@@ -93,6 +180,31 @@ public:
     Alignment getHorizontalAlignment() const;
     void setHorizontalAlignment(Alignment alignment);
 
+    RenderMode getRenderMode() const;
+    void setRenderMode(RenderMode mode);
+
+    Mode getMode() const;
+    void setMode(Mode mode);
+
+    bool isRunning() const;
+    void setRunning(bool running);
+
+    int getCountdown() const;
+    void setCountdown(int msecs);
+
+    /** Reset the stopwatch or countdown to zero elapsed time. It keeps running or stays stopped. */
+    Q_INVOKABLE void restart();
+    /** Returns the elapsed time of the stopwatch or countdown in milliseconds. */
+    Q_INVOKABLE qint64 getElapsed() const;
+
+    Coalesce getCoalesce() const;
+    void setCoalesce(Coalesce coalesce);
+
+    int getMaxUpdateRate() const;
+    void setMaxUpdateRate(int rate);
+
+    qint64 getDroppedValueCount() const;
+
     QColor getBgColor() const;
     void setBgColor(const QColor& color);
 
@@ -102,14 +214,33 @@ public:
     QColor getOffColor() const;
     void setOffColor(const QColor& color);
 
+    /** Returns the heap memory used by the scene graph nodes of this display in bytes, as of the last frame. */
+    Q_INVOKABLE qint64 getMemoryUsage() const;
+
+    SevenSegmentStats* getStats() const;
+
+    /** Returns the thread-safe value source of this display. See SevenSegmentFeed. */
+    QSharedPointer<SevenSegmentFeed> feed();
+
 signals:
 	void digitCountChanged();
 	void valueChanged();
 	void stringChanged();
+	void segmentsChanged();
 	void precisionChanged();
+	void radixChanged();
 	void digitSizeChanged();
 	void verticalAlignmentChanged();
 	void horizontalAlignmentChanged();
+	void renderModeChanged();
+	void modeChanged();
+	void runningChanged();
+	void countdownChanged();
+	/** Emitted when the countdown ran out. The countdown is stopped. */
+	void countdownFinished();
+	void coalesceChanged();
+	void maxUpdateRateChanged();
+	void droppedValueCountChanged();
 	void bgColorChanged();
 	void onColorChanged();
 	void offColorChanged();
@@ -119,8 +250,13 @@ signals:
 
 protected:
     QSGNode* updatePaintNode(QSGNode*, UpdatePaintNodeData*);
+    void updatePolish();
 
 private:
+	void flushCoalesced();
+	int takeSegments(const QByteArray& masks, int offset);
+	void showSegments(const char* masks, int size);
+
 	QScopedPointer<SevenSegmentDisplayPrivate> d_ptr;
     Q_DECLARE_PRIVATE(SevenSegmentDisplay)
 	Q_DISABLE_COPY(SevenSegmentDisplay)
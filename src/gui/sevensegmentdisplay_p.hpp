@@ -0,0 +1,405 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file sevensegmentdisplay_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef SEVENSEGMENTDISPLAY_P_HPP_
+#define SEVENSEGMENTDISPLAY_P_HPP_
+
+#include <gui/sevensegmentdisplay.hpp>
+#include <gui/displaynode_p.hpp>
+#include <gui/displaytext_p.hpp>
+#include <gui/sevensegmentfeed.hpp>
+#include <gui/sevensegmentstats.hpp>
+#include <gui/timesource_p.hpp>
+#include <gui/valueanimation_p.hpp>
+#include <gui/tracing_p.hpp>
+
+#include <QThread>
+#include <QTimer>
+#include <QVariant>
+
+/* The properties live on the GUI thread. The display node is owned by the scene graph and read on the render thread,
+ * so updatePaintNode() copies the dirty properties into it while the GUI thread is blocked. Safe with the threaded
+ * render loop. */
+class SevenSegmentDisplayPrivate
+{
+public:
+	/* Properties that changed since the last synchronization with the node. */
+	enum DirtyFlag
+	{
+		DirtyDigitCount = 0x01,
+		DirtyText = 0x02,
+		DirtyDigitSize = 0x04,
+		DirtyAlignment = 0x08,
+		DirtyRenderMode = 0x10,
+		DirtyColors = 0x20,
+		DirtyAntialiasing = 0x40,
+		DirtyTime = 0x80,
+		DirtyAnimation = 0x100,
+		DirtyAll = 0x1ff
+	};
+
+	SevenSegmentDisplayPrivate(SevenSegmentDisplay* q):
+		q_ptr(q)
+	{
+	}
+	Q_DISABLE_COPY(SevenSegmentDisplayPrivate)
+
+	/** Assign a property and mark it dirty. Returns true if the value changed. */
+	template<typename T>
+	bool assign(T& property, const T& value, int flag)
+	{
+		if (property == value)
+			return false;
+
+		property = value;
+		mDirty |= flag;
+		return true;
+	}
+
+	bool setDigitCount(int count)
+	{
+		if (!mText.setDigitCount(count))
+			return false;
+
+		// The node clears its text as well
+		mDirty |= DirtyDigitCount | DirtyText;
+		return true;
+	}
+
+	/** Display a numeric value. Does not allocate in steady state. */
+	bool display(double value)
+	{
+		SSD_TRACE_SPAN("display", mTraceId);
+		mCurrentValue = value;
+		mValue = value;
+		bool overflowed = false;
+		return textChanged(mText.setValue(value, mPrecision, &overflowed), overflowed);
+	}
+
+	bool display(QVariant v)
+	{
+		SSD_TRACE_SPAN("display", mTraceId);
+		bool updateNeeded = false;
+
+		mCurrentValue = v;
+
+		// Update value
+		switch (v.type())
+		{
+		case QVariant::Double:
+		{
+			mValue = v.toDouble();
+			bool overflowed = false;
+			updateNeeded = textChanged(mText.setValue(mValue, mPrecision, &overflowed), overflowed);
+			break;
+		}
+		case QVariant::LongLong:
+		{
+			// Integer digit extraction, no round trip through double
+			qint64 integer = v.toLongLong();
+			char buffer[integerBufferSize];
+			int size;
+			if (mFixedPoint)
+			{
+				size = formatFixedPoint(integer, mExponent, buffer, integerBufferSize);
+				mValue = (mExponent < 0) ? integer / std::pow(10.0, -mExponent) : integer * std::pow(10.0, mExponent);
+			}
+			else
+			{
+				size = formatInteger(integer, mRadix, buffer, integerBufferSize);
+				mValue = static_cast<double>(integer);
+			}
+			Q_ASSERT(size >= 0);
+			bool overflowed = false;
+			updateNeeded = textChanged(mText.setText(buffer, size, &overflowed), overflowed);
+			break;
+		}
+		case QVariant::String:
+		{
+			QString string = v.toString();
+			mValue = string.toDouble();
+			bool overflowed = false;
+			updateNeeded = textChanged(mText.setString(string, &overflowed), overflowed);
+			break;
+		}
+		case QVariant::ByteArray:
+			// Marker of the masks in mSegments, see displaySegments()
+			updateNeeded = displaySegments(mSegments.data(), static_cast<int>(mSegments.size()));
+			break;
+		default:
+			qWarning() << "BUG: Unhandled type in mCurrentValue: (" << v.typeName() << ")";
+			break;
+		}
+
+		return updateNeeded;
+	}
+
+	/** Display segment masks, which bypass the characters. The masks are copied into mSegments to show them again
+	 * when the digit count changes; in steady state without any heap allocation. */
+	bool displaySegments(const char* masks, int size)
+	{
+		SSD_TRACE_SPAN("display", mTraceId);
+		if (masks != mSegments.data())
+			mSegments.assign(masks, masks + size);
+		// A null byte array does not allocate
+		mCurrentValue = QVariant(QVariant::ByteArray);
+		mValue = 0;
+		bool overflowed = false;
+		return textChanged(mText.setSegments(masks, size, &overflowed), overflowed);
+	}
+
+	/** Display an integer in the radix. Does not allocate. */
+	bool displayInteger(qint64 value)
+	{
+		mFixedPoint = false;
+		return display(QVariant(value));
+	}
+
+	/** Display the fixed point number mantissa * 10^exponent. Does not allocate. */
+	bool displayFixedPoint(qint64 mantissa, int exponent)
+	{
+		mFixedPoint = true;
+		mExponent = exponent;
+		return display(QVariant(mantissa));
+	}
+
+	/** Start a transition from the shown value, or the current one of a running transition. */
+	void animate(double value, int duration, const QEasingCurve& easing)
+	{
+		qint64 now = monotonicMsecs();
+		ValueAnimation& a = mAnimation;
+		a.from = a.active ? a.valueAt(now) : mValue;
+		a.to = value;
+		a.start = now;
+		a.duration = duration;
+		a.easing = easing;
+		a.precision = mPrecision;
+		a.active = true;
+		++a.serial;
+		mDirty |= DirtyAnimation;
+	}
+
+	/** End a transition where it is because another value is shown. The node shows the text again. */
+	void stopAnimation()
+	{
+		if (mAnimation.active)
+		{
+			mAnimation.active = false;
+			mDirty |= DirtyAnimation | DirtyText;
+		}
+	}
+
+	/** Add a value to the current update interval. Returns true if it is the first one. */
+	bool accumulate(double value)
+	{
+		Accumulator& a = mAccumulator;
+		a.latest = value;
+		if (!a.count++)
+		{
+			a.minimum = a.maximum = a.sum = value;
+			return true;
+		}
+
+		a.minimum = qMin(a.minimum, value);
+		a.maximum = qMax(a.maximum, value);
+		a.sum += value;
+		return false;
+	}
+
+	/** Display the combined value of the current update interval. Returns true if the display changed. */
+	bool flush()
+	{
+		Accumulator& a = mAccumulator;
+		if (!a.count)
+			return false;
+
+		double value = a.latest;
+		switch (mCoalesce)
+		{
+		case SevenSegmentDisplay::CoalesceMinimum: value = a.minimum; break;
+		case SevenSegmentDisplay::CoalesceMaximum: value = a.maximum; break;
+		case SevenSegmentDisplay::CoalesceMean: value = a.sum / a.count; break;
+		default: break;
+		}
+
+		mDroppedValueCount += a.count - 1;
+		a.count = 0;
+		return display(value);
+	}
+
+	/** Drop the values of the current update interval, e.g. because they are superseded by a string. */
+	void discard()
+	{
+		mDroppedValueCount += mAccumulator.count;
+		mAccumulator.count = 0;
+	}
+
+#ifdef SSD_ENABLE_TRACING
+	/** Stamp a new value. A value that was not synchronized yet is superseded by it. */
+	void traceValue()
+	{
+		TraceRecorder& trace = TraceRecorder::instance();
+		if (mTraceId)
+			trace.valueEnd(mTraceId, "superseded");
+		mTraceId = trace.nextId();
+		trace.valueBegin(mTraceId);
+	}
+#endif
+
+	/** Display the newest value of the feed. Called on render thread while the GUI thread is blocked. */
+	void pullFeed()
+	{
+		SevenSegmentFeed::Sample sample;
+		if (!mFeed || !mFeed->take(sample))
+			return;
+
+		stopAnimation();
+		if (sample.isText)
+		{
+			QString string = QString::fromLatin1(sample.text, sample.size);
+			mCurrentValue = string;
+			mValue = string.toDouble();
+			bool overflowed = false;
+			textChanged(mText.setText(sample.text, sample.size, &overflowed), overflowed);
+		}
+		else
+			display(sample.value);
+	}
+
+	/** Copy the dirty properties into the node. Called on render thread while the GUI thread is blocked. */
+	void sync(DisplayNode* node)
+	{
+		// The digit count must be set before the text to justify it alike
+		if (mDirty & DirtyDigitCount)
+			node->setDigitCount(mText.getDigitCount());
+		// The time modes sample the text on the render thread
+		if ((mDirty & DirtyText) && mTime.mode == SevenSegmentDisplay::ModeValue)
+		{
+			if (mText.isRaw())
+				node->setSegments(mText.data(), mText.size());
+			else
+				node->setText(mText.data(), mText.size());
+		}
+		if (mDirty & DirtyDigitSize)
+			node->setDigitSize(mDigitSize);
+		if (mDirty & DirtyAlignment)
+		{
+			node->setHAlignment(mHAlignment);
+			node->setVAlignment(mVAlignment);
+		}
+		if (mDirty & DirtyRenderMode)
+			node->setRenderMode(mRenderMode);
+		if (mDirty & DirtyColors)
+		{
+			node->setBgColor(mBgColor);
+			node->setOnColor(mOnColor);
+			node->setOffColor(mOffColor);
+		}
+		if (mDirty & DirtyAntialiasing)
+			node->setAntialiasing(mAntialiasing);
+		// A new digit count clears the sampled time as well
+		if (mDirty & (DirtyTime | DirtyDigitCount))
+			node->setTimeSource(mTime);
+		if (mDirty & DirtyAnimation)
+			node->setAnimation(mAnimation);
+		mDirty = 0;
+	}
+
+	SevenSegmentDisplay* q_ptr;
+	Q_DECLARE_PUBLIC(SevenSegmentDisplay)
+
+	DisplayText mText;
+	int mDigitSize = 24;
+	SevenSegmentDisplay::Alignment mHAlignment = SevenSegmentDisplay::AlignLeft;
+	SevenSegmentDisplay::Alignment mVAlignment = SevenSegmentDisplay::AlignTop;
+	SevenSegmentDisplay::RenderMode mRenderMode = SevenSegmentDisplay::RenderSegmentNodes;
+	QColor mBgColor = QColor(Qt::transparent);
+	QColor mOnColor = QColor("green");
+	QColor mOffColor = QColor("gray");
+	bool mAntialiasing = false;
+	TimeSource mTime;
+	ValueAnimation mAnimation;
+	/* Combination of DirtyFlag. A new node receives all properties. */
+	int mDirty = DirtyAll;
+	/* Heap memory of the node as of the last synchronization. */
+	qint64 mMemoryUsage = 0;
+
+	QSharedPointer<SevenSegmentFeed> mFeed;
+	/* Created on first access. Child of the display. */
+	mutable SevenSegmentStats* mStats = nullptr;
+
+	/* Values passed to setValue() since the last display update when coalescing. */
+	struct Accumulator
+	{
+		int count = 0;
+		double latest = 0;
+		double minimum = 0;
+		double maximum = 0;
+		double sum = 0;
+	} mAccumulator;
+	SevenSegmentDisplay::Coalesce mCoalesce = SevenSegmentDisplay::CoalesceNone;
+	int mMaxUpdateRate = 0;
+	qint64 mDroppedValueCount = 0;
+	/* Limits the updates to mMaxUpdateRate. Without a rate, updates are limited by polishing once per frame. */
+	QTimer mRateTimer;
+	/* Shown value to format again when the digit count, the precision or the radix changes. Integers are stored as
+	 * LongLong; with mFixedPoint set they are the mantissa of mExponent. */
+	QVariant mCurrentValue;
+	/* Shown segment masks; mCurrentValue is a null byte array while they are shown. */
+	std::vector<char> mSegments;
+	bool mFixedPoint = false;
+	int mExponent = 0;
+	/* Value returned by getValue() */
+	double mValue = 0;
+	int mPrecision = 0;
+	int mRadix = 10;
+#ifdef SSD_ENABLE_TRACING
+	/* Traced value that was not synchronized with the render thread yet. */
+	quint64 mTraceId = 0;
+#endif
+
+private:
+	/** Report an overflow and mark a changed text dirty. Returns changed. */
+	bool textChanged(bool changed, bool overflowed)
+	{
+		if (overflowed)
+		{
+			Q_Q(SevenSegmentDisplay);
+			RenderCounters* counters = mStats ? mStats->counters() : nullptr;
+			SSD_STAT(counters, overflows += 1);
+			Q_UNUSED(counters);
+			// The feed is pulled on the render thread
+			if (QThread::currentThread() == q->thread())
+				emit q->overflow();
+			else
+				QMetaObject::invokeMethod(q, "overflow", Qt::QueuedConnection);
+		}
+		if (changed)
+			mDirty |= DirtyText;
+		return changed;
+	}
+};
+
+#endif /* SEVENSEGMENTDISPLAY_P_HPP_ */
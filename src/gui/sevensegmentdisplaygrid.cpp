@@ -0,0 +1,471 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file sevensegmentdisplaygrid.cpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <gui/sevensegmentdisplaygrid.hpp>
+#include <gui/displaynode_p.hpp>
+
+#include <algorithm>
+
+#include <QPointer>
+#include <QSGTransformNode>
+#include <QMatrix4x4>
+
+namespace
+{
+/** \internal Show a model value on a display. Strings are shown as is, everything else as number. */
+void displayValue(DisplayNode* node, const QVariant& value, int precision)
+{
+	if (value.type() == QVariant::String)
+		node->setString(value.toString());
+	else
+	{
+		bool ok = false;
+		double v = value.toDouble(&ok);
+		if (ok)
+			node->setValue(v, precision);
+		else
+			node->setString(QString());
+	}
+}
+} // namespace
+
+/** \internal Root scene graph node of the grid. Each readout is a DisplayNode below a transform node. */
+class GridNode: public QSGNode
+{
+public:
+	GridNode(QQuickWindow* window, const QSharedPointer<MaterialCache>& materialCache):
+		mWindow(window),
+		mMaterialCache(materialCache)
+	{
+	}
+
+	inline qreal getDevicePixelRatio() const { return mDevicePixelRatio; }
+	inline void setDevicePixelRatio(qreal ratio) { mDevicePixelRatio = ratio; }
+
+	inline int getCellCount() const { return static_cast<int>(mCells.size()); }
+	/** \internal Add or remove readouts. New readouts must be styled and laid out. */
+	void setCellCount(int count)
+	{
+		while (getCellCount() < count)
+		{
+			Cell cell;
+			cell.transform = new QSGTransformNode;
+			cell.display = new DisplayNode;
+			cell.display->setMaterialCache(mMaterialCache);
+			cell.display->setWindow(mWindow);
+			cell.transform->appendChildNode(cell.display);
+			appendChildNode(cell.transform);
+			mCells.push_back(cell);
+		}
+
+		while (getCellCount() > count)
+		{
+			QSGTransformNode* transform = mCells.back().transform;
+			removeChildNode(transform);
+			delete transform;
+			mCells.pop_back();
+		}
+	}
+
+	inline QSGTransformNode* transform(int cell) const { return mCells[cell].transform; }
+	inline DisplayNode* display(int cell) const { return mCells[cell].display; }
+
+private:
+	struct Cell
+	{
+		QSGTransformNode* transform; // Owned by scene graph
+		DisplayNode* display; // Owned by scene graph
+	};
+
+	QQuickWindow* mWindow;
+	QSharedPointer<MaterialCache> mMaterialCache;
+	std::vector<Cell> mCells;
+	qreal mDevicePixelRatio = 0;
+};
+
+class SevenSegmentDisplayGridPrivate
+{
+public:
+	SevenSegmentDisplayGridPrivate(SevenSegmentDisplayGrid* q):
+		q_ptr(q)
+	{
+	}
+	Q_DISABLE_COPY(SevenSegmentDisplayGridPrivate)
+
+	/** \internal Resolve the role and fetch all rows of the model. */
+	void reset()
+	{
+		mRoleId = Qt::DisplayRole;
+		int rows = 0;
+		if (mModel)
+		{
+			QByteArray role = mRole.toUtf8();
+			QHash<int, QByteArray> roles = mModel->roleNames();
+			for (QHash<int, QByteArray>::const_iterator it = roles.constBegin(); it != roles.constEnd(); ++it)
+			{
+				if (it.value() == role)
+				{
+					mRoleId = it.key();
+					break;
+				}
+			}
+			rows = mModel->rowCount();
+		}
+
+		mValues.resize(rows);
+		for (int row = 0; row < rows; ++row)
+			mValues[row] = mModel->data(mModel->index(row, 0), mRoleId);
+
+		mDirty.assign(rows, false);
+		mDirtyRows.clear();
+		mStyleDirty = true;
+		updateImplicitSize();
+		q_ptr->update();
+	}
+
+	/** \internal Fetch the values of the given rows. */
+	void fetch(int first, int last)
+	{
+		last = std::min(last, static_cast<int>(mValues.size()) - 1);
+		for (int row = std::max(first, 0); row <= last; ++row)
+		{
+			mValues[row] = mModel->data(mModel->index(row, 0), mRoleId);
+			if (!mDirty[row])
+			{
+				mDirty[row] = true;
+				mDirtyRows.push_back(row);
+			}
+		}
+		q_ptr->update();
+	}
+
+	/** \internal Connect to the signals of the model. */
+	void connectModel()
+	{
+		SevenSegmentDisplayGrid* q = q_ptr;
+		mConnections.push_back(QObject::connect(mModel.data(), &QAbstractItemModel::dataChanged, q,
+		                                        [this](const QModelIndex & topLeft, const QModelIndex & bottomRight, const QVector<int>& roles)
+		{
+			if (roles.isEmpty() || roles.contains(mRoleId))
+				fetch(topLeft.row(), bottomRight.row());
+		}));
+
+		// Structural changes are rare, so simply fetch everything again
+		auto resetter = [this]() { reset(); };
+		mConnections.push_back(QObject::connect(mModel.data(), &QAbstractItemModel::modelReset, q, resetter));
+		mConnections.push_back(QObject::connect(mModel.data(), &QAbstractItemModel::layoutChanged, q, resetter));
+		mConnections.push_back(QObject::connect(mModel.data(), &QAbstractItemModel::rowsInserted, q, resetter));
+		mConnections.push_back(QObject::connect(mModel.data(), &QAbstractItemModel::rowsRemoved, q, resetter));
+		mConnections.push_back(QObject::connect(mModel.data(), &QAbstractItemModel::rowsMoved, q, resetter));
+		mConnections.push_back(QObject::connect(mModel.data(), &QObject::destroyed, q, resetter));
+	}
+
+	void disconnectModel()
+	{
+		for (const QMetaObject::Connection& c : mConnections)
+			QObject::disconnect(c);
+		mConnections.clear();
+	}
+
+	/** \internal Returns the rectangle of a readout. */
+	QRectF cellRect(int cell) const
+	{
+		QSizeF size = DisplayNode::contentSize(mDigitCount, mDigitSize);
+		int column = cell % mColumns;
+		int line = cell / mColumns;
+		return QRectF(QPointF(column * (size.width() + mSpacing), line * (size.height() + mSpacing)), size);
+	}
+
+	void updateImplicitSize()
+	{
+		int cells = static_cast<int>(mValues.size());
+		if (!cells)
+		{
+			q_ptr->setImplicitWidth(0);
+			q_ptr->setImplicitHeight(0);
+			return;
+		}
+
+		QSizeF size = DisplayNode::contentSize(mDigitCount, mDigitSize);
+		int columns = std::min(mColumns, cells);
+		int lines = (cells + mColumns - 1) / mColumns;
+		q_ptr->setImplicitWidth(columns * size.width() + (columns - 1) * mSpacing);
+		q_ptr->setImplicitHeight(lines * size.height() + (lines - 1) * mSpacing);
+	}
+
+	/** \internal Changes the styling of all readouts. */
+	void styleChanged()
+	{
+		mStyleDirty = true;
+		updateImplicitSize();
+		q_ptr->update();
+	}
+
+	SevenSegmentDisplayGrid* const q_ptr;
+
+	QPointer<QAbstractItemModel> mModel;
+	std::vector<QMetaObject::Connection> mConnections;
+	QString mRole = QStringLiteral("display");
+	int mRoleId = Qt::DisplayRole;
+	int mColumns = 1;
+	int mSpacing = 4;
+
+	int mDigitCount = 4;
+	int mPrecision = 0;
+	int mDigitSize = 24;
+	SevenSegmentDisplay::RenderMode mRenderMode = SevenSegmentDisplay::RenderSegmentNodes;
+	QColor mBgColor = QColor(Qt::transparent);
+	QColor mOnColor = QColor("green");
+	QColor mOffColor = QColor("gray");
+
+	/* Current value of each row and the rows changed since the last sync. */
+	std::vector<QVariant> mValues;
+	std::vector<bool> mDirty;
+	std::vector<int> mDirtyRows;
+	/* All readouts must be styled, laid out and filled. */
+	bool mStyleDirty = true;
+};
+
+SevenSegmentDisplayGrid::SevenSegmentDisplayGrid(QQuickItem* parent) :
+	QQuickItem(parent), d_ptr(new SevenSegmentDisplayGridPrivate(this))
+{
+	setFlag(ItemHasContents, true);
+	connect(this, &QQuickItem::antialiasingChanged, this, [this]()
+	{
+		Q_D(SevenSegmentDisplayGrid);
+		d->styleChanged();
+	});
+}
+
+SevenSegmentDisplayGrid::~SevenSegmentDisplayGrid()
+{
+	Q_D(SevenSegmentDisplayGrid);
+	d->disconnectModel();
+}
+
+QAbstractItemModel* SevenSegmentDisplayGrid::getModel() const { Q_D(const SevenSegmentDisplayGrid); return d->mModel.data(); }
+void SevenSegmentDisplayGrid::setModel(QAbstractItemModel* model)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (d->mModel == model)
+		return;
+
+	d->disconnectModel();
+	d->mModel = model;
+	if (model)
+		d->connectModel();
+	d->reset();
+	emit modelChanged();
+}
+
+QString SevenSegmentDisplayGrid::getRole() const { Q_D(const SevenSegmentDisplayGrid); return d->mRole; }
+void SevenSegmentDisplayGrid::setRole(const QString& role)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (d->mRole != role)
+	{
+		d->mRole = role;
+		d->reset();
+		emit roleChanged();
+	}
+}
+
+int SevenSegmentDisplayGrid::getColumns() const { Q_D(const SevenSegmentDisplayGrid); return d->mColumns; }
+void SevenSegmentDisplayGrid::setColumns(int columns)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (columns < 1)
+		qWarning() << "Column count must be positive";
+	else if (d->mColumns != columns)
+	{
+		d->mColumns = columns;
+		d->styleChanged();
+		emit columnsChanged();
+	}
+}
+
+int SevenSegmentDisplayGrid::getSpacing() const { Q_D(const SevenSegmentDisplayGrid); return d->mSpacing; }
+void SevenSegmentDisplayGrid::setSpacing(int spacing)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (d->mSpacing != spacing)
+	{
+		d->mSpacing = spacing;
+		d->styleChanged();
+		emit spacingChanged();
+	}
+}
+
+int SevenSegmentDisplayGrid::getDigitCount() const { Q_D(const SevenSegmentDisplayGrid); return d->mDigitCount; }
+void SevenSegmentDisplayGrid::setDigitCount(int count)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (count < 0)
+		qWarning() << "Digit count cannot be negative";
+	else if (d->mDigitCount != count)
+	{
+		d->mDigitCount = count;
+		d->styleChanged();
+		emit digitCountChanged();
+	}
+}
+
+int SevenSegmentDisplayGrid::getPrecision() const { Q_D(const SevenSegmentDisplayGrid); return d->mPrecision; }
+void SevenSegmentDisplayGrid::setPrecision(int precision)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (precision < 0)
+		qWarning() << "Precision cannot be negative";
+	else if (d->mPrecision != precision)
+	{
+		d->mPrecision = precision;
+		d->styleChanged();
+		emit precisionChanged();
+	}
+}
+
+int SevenSegmentDisplayGrid::getDigitSize() const { Q_D(const SevenSegmentDisplayGrid); return d->mDigitSize; }
+void SevenSegmentDisplayGrid::setDigitSize(int size)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (d->mDigitSize != size)
+	{
+		d->mDigitSize = size;
+		d->styleChanged();
+		emit digitSizeChanged();
+	}
+}
+
+SevenSegmentDisplay::RenderMode SevenSegmentDisplayGrid::getRenderMode() const { Q_D(const SevenSegmentDisplayGrid); return d->mRenderMode; }
+void SevenSegmentDisplayGrid::setRenderMode(SevenSegmentDisplay::RenderMode mode)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (d->mRenderMode != mode)
+	{
+		d->mRenderMode = mode;
+		d->styleChanged();
+		emit renderModeChanged();
+	}
+}
+
+QColor SevenSegmentDisplayGrid::getBgColor() const { Q_D(const SevenSegmentDisplayGrid); return d->mBgColor; }
+void SevenSegmentDisplayGrid::setBgColor(const QColor& color)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (d->mBgColor != color)
+	{
+		d->mBgColor = color;
+		d->styleChanged();
+		emit bgColorChanged();
+	}
+}
+
+QColor SevenSegmentDisplayGrid::getOnColor() const { Q_D(const SevenSegmentDisplayGrid); return d->mOnColor; }
+void SevenSegmentDisplayGrid::setOnColor(const QColor& color)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (d->mOnColor != color)
+	{
+		d->mOnColor = color;
+		d->styleChanged();
+		emit onColorChanged();
+	}
+}
+
+QColor SevenSegmentDisplayGrid::getOffColor() const { Q_D(const SevenSegmentDisplayGrid); return d->mOffColor; }
+void SevenSegmentDisplayGrid::setOffColor(const QColor& color)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	if (d->mOffColor != color)
+	{
+		d->mOffColor = color;
+		d->styleChanged();
+		emit offColorChanged();
+	}
+}
+
+/** \internal Called on render thread while the GUI thread is blocked.
+ * On style changes all readouts are updated, otherwise only the ones of changed rows. */
+QSGNode* SevenSegmentDisplayGrid::updatePaintNode(QSGNode* oldRoot, QQuickItem::UpdatePaintNodeData* /*d*/)
+{
+	Q_D(SevenSegmentDisplayGrid);
+	GridNode* root = static_cast<GridNode*>(oldRoot);
+	if (!root)
+		root = new GridNode(window(), MaterialCache::forWindow(window()));
+
+	int cells = static_cast<int>(d->mValues.size());
+	if (root->getCellCount() != cells)
+	{
+		root->setCellCount(cells);
+		d->mStyleDirty = true;
+	}
+
+	// The level of detail depends on the size in device pixels
+	qreal ratio = window()->effectiveDevicePixelRatio();
+	if (!qFuzzyCompare(root->getDevicePixelRatio(), ratio))
+	{
+		root->setDevicePixelRatio(ratio);
+		d->mStyleDirty = true;
+	}
+
+	if (d->mStyleDirty)
+	{
+		for (int i = 0; i < cells; ++i)
+		{
+			DisplayNode* display = root->display(i);
+			display->setDevicePixelRatio(ratio);
+			display->setDigitCount(d->mDigitCount);
+			display->setDigitSize(d->mDigitSize);
+			display->setRenderMode(d->mRenderMode);
+			display->setAntialiasing(antialiasing());
+			display->setBgColor(d->mBgColor);
+			display->setOnColor(d->mOnColor);
+			display->setOffColor(d->mOffColor);
+			displayValue(display, d->mValues[i], d->mPrecision);
+
+			QRectF rect = d->cellRect(i);
+			QMatrix4x4 m;
+			m.translate(rect.x(), rect.y());
+			root->transform(i)->setMatrix(m);
+			display->update(QRectF(QPointF(), rect.size()));
+		}
+	}
+	else
+	{
+		for (int i : d->mDirtyRows)
+		{
+			DisplayNode* display = root->display(i);
+			displayValue(display, d->mValues[i], d->mPrecision);
+			display->update(QRectF(QPointF(), d->cellRect(i).size()));
+		}
+	}
+
+	for (int i : d->mDirtyRows)
+		d->mDirty[i] = false;
+	d->mDirtyRows.clear();
+	d->mStyleDirty = false;
+
+	return root;
+}
@@ -0,0 +1,120 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file sevensegmentdisplaygrid.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef SEVENSEGMENTDISPLAYGRID_HPP
+#define SEVENSEGMENTDISPLAYGRID_HPP
+
+#include <gui/sevensegmentdisplay.hpp>
+
+#include <QQuickItem>
+#include <QAbstractItemModel>
+
+class SevenSegmentDisplayGridPrivate;
+
+/** QQuick widget that shows one seven-segment readout per row of a model.
+ * All readouts share the styling of the grid and are rendered from a single scene graph node tree.
+ * Only readouts whose rows changed are updated. */
+class SevenSegmentDisplayGrid : public QQuickItem
+{
+	Q_OBJECT
+
+	/** Property that holds the model. Each row is shown by one readout. */
+	Q_PROPERTY(QAbstractItemModel* model READ getModel WRITE setModel NOTIFY modelChanged)
+	/** Property that controls the name of the role that provides the values (numbers or strings). */
+	Q_PROPERTY(QString role READ getRole WRITE setRole NOTIFY roleChanged)
+	/** Property that controls the count of readouts per line. */
+	Q_PROPERTY(int columns READ getColumns WRITE setColumns NOTIFY columnsChanged)
+	/** Property that controls the space between readouts. */
+	Q_PROPERTY(int spacing READ getSpacing WRITE setSpacing NOTIFY spacingChanged)
+
+	/* Styling properties shared with SevenSegmentDisplay. */
+	Q_PROPERTY(int digitCount READ getDigitCount WRITE setDigitCount NOTIFY digitCountChanged)
+	Q_PROPERTY(int precision READ getPrecision WRITE setPrecision NOTIFY precisionChanged)
+	Q_PROPERTY(int digitSize READ getDigitSize WRITE setDigitSize NOTIFY digitSizeChanged)
+	Q_PROPERTY(SevenSegmentDisplay::RenderMode renderMode READ getRenderMode WRITE setRenderMode NOTIFY renderModeChanged)
+	Q_PROPERTY(QColor bgColor READ getBgColor WRITE setBgColor NOTIFY bgColorChanged)
+	Q_PROPERTY(QColor onColor READ getOnColor WRITE setOnColor NOTIFY onColorChanged)
+	Q_PROPERTY(QColor offColor READ getOffColor WRITE setOffColor NOTIFY offColorChanged)
+
+public:
+	SevenSegmentDisplayGrid(QQuickItem* parent = nullptr);
+	virtual ~SevenSegmentDisplayGrid();
+
+	QAbstractItemModel* getModel() const;
+	void setModel(QAbstractItemModel* model);
+
+	QString getRole() const;
+	void setRole(const QString& role);
+
+	int getColumns() const;
+	void setColumns(int columns);
+
+	int getSpacing() const;
+	void setSpacing(int spacing);
+
+	int getDigitCount() const;
+	void setDigitCount(int count);
+
+	int getPrecision() const;
+	void setPrecision(int precision);
+
+	int getDigitSize() const;
+	void setDigitSize(int size);
+
+	SevenSegmentDisplay::RenderMode getRenderMode() const;
+	void setRenderMode(SevenSegmentDisplay::RenderMode mode);
+
+	QColor getBgColor() const;
+	void setBgColor(const QColor& color);
+
+	QColor getOnColor() const;
+	void setOnColor(const QColor& color);
+
+	QColor getOffColor() const;
+	void setOffColor(const QColor& color);
+
+signals:
+	void modelChanged();
+	void roleChanged();
+	void columnsChanged();
+	void spacingChanged();
+	void digitCountChanged();
+	void precisionChanged();
+	void digitSizeChanged();
+	void renderModeChanged();
+	void bgColorChanged();
+	void onColorChanged();
+	void offColorChanged();
+
+protected:
+	QSGNode* updatePaintNode(QSGNode*, UpdatePaintNodeData*);
+
+private:
+	QScopedPointer<SevenSegmentDisplayGridPrivate> d_ptr;
+	Q_DECLARE_PRIVATE(SevenSegmentDisplayGrid)
+	Q_DISABLE_COPY(SevenSegmentDisplayGrid)
+};
+
+#endif // SEVENSEGMENTDISPLAYGRID_HPP
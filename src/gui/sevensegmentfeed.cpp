@@ -0,0 +1,167 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file sevensegmentfeed.cpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <gui/sevensegmentfeed.hpp>
+
+#include <cstring>
+
+#include <QMetaObject>
+#include <QObject>
+#include <QThread>
+
+namespace
+{
+Q_CONSTEXPR quint64 textFlag = Q_UINT64_C(1) << 32;
+} // namespace
+
+SevenSegmentFeed::SevenSegmentFeed(QObject* receiver):
+	mTicket(0), mLatest(0), mAbandoned(0), mTaken(0), mDropped(0), mScheduled(false), mPosting(0), mReceiver(receiver)
+{
+	for (Slot& slot : mSlots)
+	{
+		slot.sequence.store(0, std::memory_order_relaxed);
+		slot.header.store(0, std::memory_order_relaxed);
+		slot.value.store(0, std::memory_order_relaxed);
+		for (std::atomic<quint64>& word : slot.text)
+			word.store(0, std::memory_order_relaxed);
+	}
+}
+
+void SevenSegmentFeed::setValue(double value)
+{
+	publish(false, value, nullptr, 0);
+}
+
+void SevenSegmentFeed::setText(const char* text, int size)
+{
+	if (size < 0)
+		size = static_cast<int>(std::strlen(text));
+	publish(true, 0, text, qMin<int>(size, TextCapacity));
+}
+
+void SevenSegmentFeed::publish(bool isText, double value, const char* text, int size)
+{
+	quint64 ticket;
+	Slot* slot;
+	for (;;)
+	{
+		ticket = mTicket.fetch_add(1, std::memory_order_relaxed) + 1;
+		slot = &mSlots[ticket % SlotCount];
+
+		// Producers lapped all slots and a newer value is stored or being written; this value is outdated.
+		quint64 sequence = slot->sequence.load(std::memory_order_relaxed);
+		if (sequence > 2 * ticket)
+			return;
+		if (!(sequence & 1) && slot->sequence.compare_exchange_strong(sequence, 2 * ticket - 1,
+		                                                              std::memory_order_acquire,
+		                                                              std::memory_order_relaxed))
+			break;
+
+		// An older producer is still writing this slot. The value is the newest one, so it is not dropped but
+		// published again under the next ticket, which maps to the next slot. The abandoned ticket carries no value.
+		mAbandoned.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Release stores: a consumer that sees any part of the payload also sees the odd sequence.
+	quint64 bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	slot->header.store((isText ? textFlag : 0) | static_cast<quint32>(size), std::memory_order_release);
+	slot->value.store(bits, std::memory_order_release);
+	if (isText)
+	{
+		quint64 words[TextWords] = {};
+		std::memcpy(words, text, size);
+		for (int i = 0; i < TextWords; ++i)
+			slot->text[i].store(words[i], std::memory_order_release);
+	}
+	slot->sequence.store(2 * ticket, std::memory_order_release);
+
+	// Become the latest value unless a newer one was completed meanwhile
+	quint64 latest = mLatest.load(std::memory_order_relaxed);
+	while (latest < ticket && !mLatest.compare_exchange_weak(latest, ticket, std::memory_order_seq_cst,
+	                                                          std::memory_order_relaxed))
+	{
+	}
+
+	if (latest < ticket)
+		schedule();
+}
+
+bool SevenSegmentFeed::take(Sample& sample)
+{
+	// Reset before reading: a value completed afterwards schedules the next frame.
+	mScheduled.store(false, std::memory_order_seq_cst);
+
+	quint64 ticket = mLatest.load(std::memory_order_seq_cst);
+	if (ticket == mTaken)
+		return false;
+
+	// Acquire loads keep the validation below after the payload reads.
+	const Slot& slot = mSlots[ticket % SlotCount];
+	if (slot.sequence.load(std::memory_order_acquire) != 2 * ticket)
+		return false;
+	quint64 header = slot.header.load(std::memory_order_acquire);
+	quint64 bits = slot.value.load(std::memory_order_acquire);
+	quint64 words[TextWords];
+	if (header & textFlag)
+	{
+		for (int i = 0; i < TextWords; ++i)
+			words[i] = slot.text[i].load(std::memory_order_acquire);
+	}
+	if (slot.sequence.load(std::memory_order_relaxed) != 2 * ticket)
+		return false;
+
+	sample.isText = header & textFlag;
+	sample.size = static_cast<int>(header & 0xffffffff);
+	std::memcpy(&sample.value, &bits, sizeof(bits));
+	if (sample.isText)
+		std::memcpy(sample.text, words, sample.size);
+
+	mDropped.fetch_add(ticket - mTaken - 1, std::memory_order_relaxed);
+	mTaken = ticket;
+	return true;
+}
+
+void SevenSegmentFeed::detach()
+{
+	// Producers that loaded the receiver before it was cleared finish posting before the display is destroyed.
+	mReceiver.store(nullptr, std::memory_order_seq_cst);
+	while (mPosting.load(std::memory_order_seq_cst))
+		QThread::yieldCurrentThread();
+}
+
+/** \internal Request a frame from the receiver unless one is requested already. */
+void SevenSegmentFeed::schedule()
+{
+	if (mScheduled.exchange(true, std::memory_order_seq_cst))
+		return;
+
+	// The count is raised before loading the receiver, so detach() either sees the count or this sees nullptr.
+	mPosting.fetch_add(1, std::memory_order_seq_cst);
+	if (QObject* receiver = mReceiver.load(std::memory_order_seq_cst))
+		QMetaObject::invokeMethod(receiver, "update", Qt::QueuedConnection);
+	mPosting.fetch_sub(1, std::memory_order_seq_cst);
+}
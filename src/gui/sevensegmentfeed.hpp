@@ -0,0 +1,125 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file sevensegmentfeed.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef SEVENSEGMENTFEED_HPP
+#define SEVENSEGMENTFEED_HPP
+
+#include <atomic>
+
+#include <QtGlobal>
+
+class QObject;
+
+/** Thread-safe value source of a SevenSegmentDisplay.
+ * Any number of producer threads may publish values without locking and without posting an event per value.
+ * Each value is written into one of a few slots guarded by a sequence lock, and the newest completely written
+ * one becomes the latest value. A producer that finds its slot still being written by an older one moves on to the
+ * next slot, so the newest value is never lost to an older one. The display takes the latest value once per frame
+ * while synchronizing with the render thread; values published in between are dropped. Producers never wait for
+ * each other or for the display.
+ * The first value after a frame posts a single queued update() to the display, because an item may only be updated
+ * on the GUI thread; no lock is taken for it. Published values do not emit the change signals of the display.
+ * Obtain the feed of a display from SevenSegmentDisplay::feed(). */
+class SevenSegmentFeed
+{
+public:
+	/** Create a feed that schedules an update of the receiver when a value is published.
+	 * The receiver must provide an update() slot. */
+	explicit SevenSegmentFeed(QObject* receiver = nullptr);
+
+	/** Maximum length of a text in characters. Longer texts are truncated. */
+	enum { TextCapacity = 32 };
+
+	/** A published value. */
+	struct Sample
+	{
+		bool isText;
+		double value;
+		int size;
+		char text[TextCapacity];
+	};
+
+	/** Publish a numeric value. It is formatted with the precision of the display. */
+	void setValue(double value);
+	/** Publish a Latin-1 text of the given size (-1 for a null terminated text). */
+	void setText(const char* text, int size = -1);
+
+	/** Take the latest sample if something was published since the last call.
+	 * Only a single consumer is supported. Returns false if nothing new is available, or in the rare case that
+	 * the slot of the latest sample is overwritten while reading; the overwriting producer schedules again. */
+	bool take(Sample& sample);
+
+	/** Count of published values that were never taken. */
+	inline quint64 getDroppedCount() const
+	{
+		// Abandoned tickets not yet passed by the consumer are subtracted early; never report more than were dropped
+		quint64 dropped = mDropped.load(std::memory_order_relaxed);
+		quint64 abandoned = mAbandoned.load(std::memory_order_relaxed);
+		return dropped > abandoned ? dropped - abandoned : 0;
+	}
+
+private:
+	friend class SevenSegmentDisplay;
+
+	Q_DISABLE_COPY(SevenSegmentFeed)
+
+	/** Stop scheduling updates on the receiver. Called on the GUI thread when the display is destroyed; returns once
+	 * no producer is posting to it anymore. */
+	void detach();
+
+	void publish(bool isText, double value, const char* text, int size);
+	void schedule();
+
+	enum { SlotCount = 8, TextWords = TextCapacity / sizeof(quint64) };
+
+	/* The payload is stored as atomic words so that the optimistic reads of the consumer are no data races. */
+	struct Slot
+	{
+		/* 2 * ticket of the stored value; odd while a producer is writing. */
+		std::atomic<quint64> sequence;
+		std::atomic<quint64> header;
+		std::atomic<quint64> value;
+		std::atomic<quint64> text[TextWords];
+	};
+
+	Slot mSlots[SlotCount];
+	/* Ticket of the last started and of the newest completely written value. */
+	std::atomic<quint64> mTicket;
+	std::atomic<quint64> mLatest;
+	/* Count of tickets given up by producers that retried with the next one. */
+	std::atomic<quint64> mAbandoned;
+
+	/* Consumer side. */
+	quint64 mTaken;
+	std::atomic<quint64> mDropped;
+	std::atomic<bool> mScheduled;
+
+	/* Count of producers posting to the receiver; detach() waits for them. */
+	std::atomic<int> mPosting;
+	std::atomic<QObject*> mReceiver;
+};
+
+#endif // SEVENSEGMENTFEED_HPP
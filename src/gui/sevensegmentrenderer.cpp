@@ -0,0 +1,255 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file sevensegmentrenderer.cpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <gui/sevensegmentrenderer.hpp>
+#include <gui/segmentgeometry_p.hpp>
+#include <gui/numberformat_p.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include <QDebug>
+#include <QPainter>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QVarLengthArray>
+
+namespace
+{
+/** \internal Renders a range of a batch. Signals its completion when run on a pool. */
+class RenderTask: public QRunnable
+{
+public:
+	RenderTask(const SevenSegmentRenderer& renderer, const QStringList& strings, QImage* images, int first, int last,
+	           std::atomic<int>& truncated, QSemaphore& done):
+		mRenderer(renderer), mStrings(strings), mImages(images), mFirst(first), mLast(last), mTruncated(truncated),
+		mDone(done)
+	{
+	}
+
+	void run()
+	{
+		renderRange();
+		mDone.release();
+	}
+
+	void renderRange()
+	{
+		int truncated = 0;
+		for (int i = mFirst; i < mLast; ++i)
+			truncated += !mRenderer.render(mStrings.at(i), mImages[i]);
+		mTruncated += truncated;
+	}
+
+private:
+	const SevenSegmentRenderer& mRenderer;
+	const QStringList& mStrings;
+	QImage* mImages;
+	int mFirst;
+	int mLast;
+	std::atomic<int>& mTruncated;
+	QSemaphore& mDone;
+};
+} // namespace
+
+SevenSegmentRenderer::SevenSegmentRenderer()
+{
+	layout();
+}
+
+void SevenSegmentRenderer::setDigitCount(int count)
+{
+	if (count < 0)
+		qWarning() << "Digit count cannot be negative";
+	else if (count != mDigitCount)
+	{
+		mDigitCount = count;
+		layout();
+	}
+}
+
+void SevenSegmentRenderer::setDigitSize(int size)
+{
+	if (size < 0)
+		qWarning() << "Digit size cannot be negative";
+	else if (size != mDigitSize)
+	{
+		mDigitSize = size;
+		layout();
+	}
+}
+
+void SevenSegmentRenderer::setPrecision(int precision)
+{
+	if (precision < 0)
+		qWarning() << "Precision cannot be negative";
+	else
+		mPrecision = precision;
+}
+
+QSize SevenSegmentRenderer::getImageSize() const
+{
+	return QSize(static_cast<int>(std::ceil(baseDigitWidth * mDigitSize / baseDigitHeight * mDigitCount)), mDigitSize);
+}
+
+bool SevenSegmentRenderer::render(const QString& string, QImage& image) const
+{
+	QByteArray text = string.toLatin1();
+	return draw(text.constData(), text.size(), image);
+}
+
+bool SevenSegmentRenderer::render(double value, QImage& image) const
+{
+	char buffer[formatBufferSize];
+	int size = formatFixed(value, mPrecision, buffer, formatBufferSize);
+	if (size < 0)
+		return render(QString::number(value, 'f', mPrecision), image);
+	return draw(buffer, size, image);
+}
+
+bool SevenSegmentRenderer::renderSegments(const QByteArray& masks, QImage& image) const
+{
+	QVarLengthArray<quint16, 64> codes(mDigitCount);
+	int size = qMin(masks.size(), mDigitCount);
+	int blank = mDigitCount - size;
+	std::fill_n(codes.data(), blank, quint16(0));
+	for (int i = 0; i < size; ++i)
+		codes[blank + i] = static_cast<quint8>(masks[i]);
+	paint(codes.data(), image);
+	return masks.size() <= mDigitCount;
+}
+
+bool SevenSegmentRenderer::render(const QString& string, uchar* buffer, int bytesPerLine, QImage::Format format) const
+{
+	QSize size = getImageSize();
+	QImage image(buffer, size.width(), size.height(), bytesPerLine, format);
+	return render(string, image);
+}
+
+int SevenSegmentRenderer::render(const QStringList& strings, QVector<QImage>& images, QThreadPool* pool) const
+{
+	if (!pool)
+		pool = QThreadPool::globalInstance();
+
+	int count = strings.size();
+	images.resize(count);
+	if (!count)
+		return 0;
+
+	// A few ranges per thread balance the load without a task per image
+	int tasks = qMin(count, qMax(1, pool->maxThreadCount()) * 4);
+	int chunk = (count + tasks - 1) / tasks;
+
+	/* Ranges without an idle thread are rendered by the caller. Waiting for queued tasks instead would deadlock
+	 * when the caller is a thread of the pool and all other threads of the pool wait as well. */
+	std::atomic<int> truncated(0);
+	QSemaphore done;
+	QImage* data = images.data();
+	int started = 0;
+	for (int first = 0; first < count; first += chunk)
+	{
+		RenderTask* task = new RenderTask(*this, strings, data, first, qMin(first + chunk, count), truncated, done);
+		if (pool->tryStart(task))
+			++started;
+		else
+		{
+			task->renderRange();
+			delete task;
+		}
+	}
+	done.acquire(started);
+
+	return truncated;
+}
+
+/** \internal Calculate the outlines of all elements in image coordinates.
+ * Uses the same layout as the scene graph nodes (see digitTransforms()). */
+void SevenSegmentRenderer::layout()
+{
+	const Tessellation& shapes = tessellation(detailForPixelSize(mDigitSize));
+	qreal scale = mDigitSize / baseDigitHeight;
+	qreal digitWidth = baseDigitWidth * scale;
+
+	mPoints.clear();
+	mPolygonStarts.clear();
+	for (int digit = 0; digit < mDigitCount; ++digit)
+	{
+		QMatrix mats[elementCount];
+		digitTransforms(QRectF(digit * digitWidth, 0, digitWidth, mDigitSize), scale, mats);
+		for (int i = 0; i < elementCount; ++i)
+		{
+			const ElementShape& shape = (i < 7) ? shapes.segment(segRotation[i]) : shapes.dot;
+			mPolygonStarts.push_back(static_cast<int>(mPoints.size()));
+			for (int k = 0; k < shape.outlineCount; ++k)
+			{
+				int j = shape.outline[k];
+				mPoints.push_back(mats[i].map(QPointF(shape.x[j], shape.y[j])));
+			}
+		}
+	}
+	mPolygonStarts.push_back(static_cast<int>(mPoints.size()));
+}
+
+/** \internal Decode the text and paint it. */
+bool SevenSegmentRenderer::draw(const char* text, int size, QImage& image) const
+{
+	QVarLengthArray<quint16, 64> codes(mDigitCount);
+	bool fits = segmentCodes(text, size, codes.data(), mDigitCount);
+	paint(codes.data(), image);
+	return fits;
+}
+
+/** \internal Fill the image with the background and draw the disabled, then the enabled elements.
+ * The colon has no disabled state. */
+void SevenSegmentRenderer::paint(const quint16* codes, QImage& image) const
+{
+	if (image.isNull())
+		image = QImage(getImageSize(), QImage::Format_ARGB32_Premultiplied);
+
+	QPainter painter(&image);
+	painter.setCompositionMode(QPainter::CompositionMode_Source);
+	painter.fillRect(image.rect(), mBgColor);
+	painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+	painter.setRenderHint(QPainter::Antialiasing, mAntialiasing);
+	painter.setPen(Qt::NoPen);
+
+	for (int on = 0; on < 2; ++on)
+	{
+		painter.setBrush(on ? mOnColor : mOffColor);
+		for (int digit = 0; digit < mDigitCount; ++digit)
+		{
+			for (int i = 0; i < (on ? elementCount : 8); ++i)
+			{
+				if (bool(codes[digit] & elementBit(i)) != bool(on))
+					continue;
+				const int* start = &mPolygonStarts[digit * elementCount + i];
+				painter.drawConvexPolygon(&mPoints[start[0]], start[1] - start[0]);
+			}
+		}
+	}
+}
@@ -0,0 +1,122 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file sevensegmentrenderer.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef SEVENSEGMENTRENDERER_HPP
+#define SEVENSEGMENTRENDERER_HPP
+
+#include <vector>
+
+#include <QByteArray>
+#include <QColor>
+#include <QImage>
+#include <QPointF>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QThreadPool;
+
+/** Rasterizes seven segment displays into images without a window, a scene graph or a QML engine.
+ * The segments have the shapes and the characters the glyphs of SevenSegmentDisplay. Content is laid out like
+ * SevenSegmentDisplay with top left alignment.
+ * Configure the renderer once, then call the render functions. They are const and may be called concurrently
+ * from any thread, as long as the configuration is not changed meanwhile. */
+class SevenSegmentRenderer
+{
+public:
+	SevenSegmentRenderer();
+
+	int getDigitCount() const { return mDigitCount; }
+	void setDigitCount(int count);
+
+	/** Height of a digit in pixels. */
+	int getDigitSize() const { return mDigitSize; }
+	void setDigitSize(int size);
+
+	/** Count of decimal places of rendered values. */
+	int getPrecision() const { return mPrecision; }
+	void setPrecision(int precision);
+
+	const QColor& getBgColor() const { return mBgColor; }
+	void setBgColor(const QColor& color) { mBgColor = color; }
+	const QColor& getOnColor() const { return mOnColor; }
+	void setOnColor(const QColor& color) { mOnColor = color; }
+	const QColor& getOffColor() const { return mOffColor; }
+	void setOffColor(const QColor& color) { mOffColor = color; }
+
+	/** Smooth the edges of the elements (default: true). */
+	bool getAntialiasing() const { return mAntialiasing; }
+	void setAntialiasing(bool antialiasing) { mAntialiasing = antialiasing; }
+
+	/** Size of an image that exactly holds the digits. */
+	QSize getImageSize() const;
+
+	/** Render a Latin-1 string into the image.
+	 * A null image is allocated with getImageSize() in Format_ARGB32_Premultiplied. Otherwise the whole image is
+	 * filled with the background color and the digits are drawn in its top left corner.
+	 * \return False if the string had to be truncated.
+	 */
+	bool render(const QString& string, QImage& image) const;
+	/** Render a value in fixed point notation with the precision into the image. */
+	bool render(double value, QImage& image) const;
+	/** Render one segment mask per digit into the image, like SevenSegmentDisplay::setSegments().
+	 * Bit 0-6 control the segments A-G, bit 7 the dot. Leading digits without a mask are blank.
+	 * \return False if there were more masks than digits.
+	 */
+	bool renderSegments(const QByteArray& masks, QImage& image) const;
+	/** Render into a caller-provided buffer of getImageSize() pixels with the given stride and 32 bit format. */
+	bool render(const QString& string, uchar* buffer, int bytesPerLine,
+	            QImage::Format format = QImage::Format_ARGB32_Premultiplied) const;
+
+	/** Render many strings in parallel on a thread pool. Blocks until all images are rendered.
+	 * images is resized to the count of strings; null images are allocated.
+	 * \return The count of strings that had to be truncated.
+	 */
+	int render(const QStringList& strings, QVector<QImage>& images, QThreadPool* pool = nullptr) const;
+
+private:
+	void layout();
+	bool draw(const char* text, int size, QImage& image) const;
+	void paint(const quint16* codes, QImage& image) const;
+
+	/* The glyph atlas paints segment codes with a colon, which masks cannot express. */
+	friend class GlyphAtlas;
+
+	int mDigitCount = 4;
+	int mDigitSize = 24;
+	int mPrecision = 0;
+	QColor mBgColor = QColor(Qt::transparent);
+	QColor mOnColor = QColor("green");
+	QColor mOffColor = QColor("gray");
+	bool mAntialiasing = true;
+
+	/* Outlines of the elements of all digits in image coordinates, 10 per digit. The polygons are convex. */
+	std::vector<QPointF> mPoints;
+	std::vector<int> mPolygonStarts;
+};
+
+#endif // SEVENSEGMENTRENDERER_HPP
@@ -0,0 +1,94 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file sevensegmentstats.cpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <gui/sevensegmentstats.hpp>
+#include <gui/renderstats_p.hpp>
+
+#include <QDebug>
+#include <QMetaObject>
+
+SevenSegmentStats::SevenSegmentStats(QObject* parent):
+	QObject(parent), mCounters(new RenderCounters)
+{
+}
+
+SevenSegmentStats::~SevenSegmentStats()
+{
+}
+
+void SevenSegmentStats::setEnabled(bool enabled)
+{
+#ifndef SSD_ENABLE_STATS
+	if (enabled)
+	{
+		qWarning() << "Render statistics are not compiled in (SSD_ENABLE_STATS)";
+		return;
+	}
+#endif
+	if (enabled != mEnabled)
+	{
+		mEnabled = enabled;
+		emit enabledChanged();
+	}
+}
+
+qint64 SevenSegmentStats::getPaintNodeUpdates() const { return mCounters->paintNodeUpdates; }
+qint64 SevenSegmentStats::getGeometryFrames() const { return mCounters->geometryFrames; }
+qint64 SevenSegmentStats::getSegmentFrames() const { return mCounters->segmentFrames; }
+qint64 SevenSegmentStats::getTouchedDigits() const { return mCounters->touchedDigits; }
+qint64 SevenSegmentStats::getTouchedVertices() const { return mCounters->touchedVertices; }
+qint64 SevenSegmentStats::getDirtiedMaterials() const { return mCounters->dirtiedMaterials; }
+qint64 SevenSegmentStats::getOverflows() const { return mCounters->overflows; }
+qint64 SevenSegmentStats::getUpdateTime() const { return mCounters->updateNanoseconds; }
+
+void SevenSegmentStats::reset()
+{
+	for (std::atomic<qint64>* counter : { &mCounters->paintNodeUpdates, &mCounters->geometryFrames,
+	                                      &mCounters->segmentFrames, &mCounters->touchedDigits,
+	                                      &mCounters->touchedVertices, &mCounters->dirtiedMaterials,
+	                                      &mCounters->overflows, &mCounters->updateNanoseconds })
+		counter->store(0);
+	emit changed();
+}
+
+RenderCounters* SevenSegmentStats::counters() const
+{
+	return mEnabled ? mCounters.data() : nullptr;
+}
+
+void SevenSegmentStats::notify()
+{
+	if (mNotifying.exchange(true))
+		return;
+
+	QMetaObject::invokeMethod(this, "deliverChanged", Qt::QueuedConnection);
+}
+
+void SevenSegmentStats::deliverChanged()
+{
+	mNotifying = false;
+	emit changed();
+}
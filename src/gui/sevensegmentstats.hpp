@@ -0,0 +1,107 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file sevensegmentstats.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef SEVENSEGMENTSTATS_HPP
+#define SEVENSEGMENTSTATS_HPP
+
+#include <atomic>
+
+#include <QObject>
+#include <QScopedPointer>
+
+struct RenderCounters;
+
+/** Render statistics of a SevenSegmentDisplay, see SevenSegmentDisplay::stats.
+ * Collection is off by default and must be switched on with the enabled property. Builds without
+ * SSD_ENABLE_STATS contain no collection code; enabled cannot be set there.
+ * All counters are cumulative since the creation or the last reset(). They are updated once per frame. */
+class SevenSegmentStats : public QObject
+{
+	Q_OBJECT
+
+	/** Property that switches the collection on. */
+	Q_PROPERTY(bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged)
+	/** Invocations of updatePaintNode(). */
+	Q_PROPERTY(qint64 paintNodeUpdates READ getPaintNodeUpdates NOTIFY changed)
+	/** Frames that laid out the digits again. */
+	Q_PROPERTY(qint64 geometryFrames READ getGeometryFrames NOTIFY changed)
+	/** Frames that displayed changed segments. */
+	Q_PROPERTY(qint64 segmentFrames READ getSegmentFrames NOTIFY changed)
+	/** Digits whose segments were displayed again. */
+	Q_PROPERTY(qint64 touchedDigits READ getTouchedDigits NOTIFY changed)
+	/** Vertices written by layouts and by segment color changes. */
+	Q_PROPERTY(qint64 touchedVertices READ getTouchedVertices NOTIFY changed)
+	/** Materials that were switched or changed. */
+	Q_PROPERTY(qint64 dirtiedMaterials READ getDirtiedMaterials NOTIFY changed)
+	/** Strings and values that did not fit into the digits. */
+	Q_PROPERTY(qint64 overflows READ getOverflows NOTIFY changed)
+	/** Time spent in updating the scene graph nodes in nanoseconds. */
+	Q_PROPERTY(qint64 updateTime READ getUpdateTime NOTIFY changed)
+
+public:
+	explicit SevenSegmentStats(QObject* parent = nullptr);
+	~SevenSegmentStats();
+
+	bool isEnabled() const { return mEnabled; }
+	void setEnabled(bool enabled);
+
+	qint64 getPaintNodeUpdates() const;
+	qint64 getGeometryFrames() const;
+	qint64 getSegmentFrames() const;
+	qint64 getTouchedDigits() const;
+	qint64 getTouchedVertices() const;
+	qint64 getDirtiedMaterials() const;
+	qint64 getOverflows() const;
+	qint64 getUpdateTime() const;
+
+	/** Set all counters to zero. */
+	Q_INVOKABLE void reset();
+
+signals:
+	void enabledChanged();
+	/** Emitted on the GUI thread after a frame updated the counters. */
+	void changed();
+
+private slots:
+	void deliverChanged();
+
+private:
+	friend class SevenSegmentDisplay;
+	friend class SevenSegmentDisplayPrivate;
+
+	Q_DISABLE_COPY(SevenSegmentStats)
+
+	/** Returns the counters to update or null when collection is off. */
+	RenderCounters* counters() const;
+	/** Schedule the changed() signal. May be called from the render thread; posts at most one event. */
+	void notify();
+
+	const QScopedPointer<RenderCounters> mCounters;
+	bool mEnabled = false;
+	std::atomic<bool> mNotifying { false };
+};
+
+#endif // SEVENSEGMENTSTATS_HPP
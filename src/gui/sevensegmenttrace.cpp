@@ -0,0 +1,214 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file sevensegmenttrace.cpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <gui/sevensegmenttrace.hpp>
+#include <gui/tracing_p.hpp>
+
+#include <QDebug>
+
+#ifdef SSD_ENABLE_TRACING
+
+#include <cstdio>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+
+namespace
+{
+/** \internal Write a string as the content of a JSON string literal, escaping quotes, backslashes and control
+ * characters. Thread names are chosen by the application and may contain any of them. */
+void writeJsonString(FILE* file, const char* string)
+{
+	for (const char* c = string; *c; ++c)
+	{
+		const unsigned char u = static_cast<unsigned char>(*c);
+		if (u == '"' || u == '\\')
+			std::fprintf(file, "\\%c", u);
+		else if (u < 0x20)
+			std::fprintf(file, "\\u%04x", u);
+		else
+			std::fputc(u, file);
+	}
+}
+} // namespace
+
+TraceRecorder& TraceRecorder::instance()
+{
+	static TraceRecorder recorder;
+	return recorder;
+}
+
+TraceRecorder::TraceRecorder():
+	mActive(false), mLastId(0)
+{
+	QString path = QString::fromLocal8Bit(qgetenv("SSD_TRACE_FILE"));
+	if (!path.isEmpty())
+		start(path);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+	if (isActive())
+		stop();
+}
+
+bool TraceRecorder::start(const QString& path)
+{
+	QMutexLocker lock(&mMutex);
+	if (isActive())
+		return false;
+
+	mPath = path;
+	mEvents.clear();
+	mThreadNames.clear();
+	++mGeneration;
+	mDropped = 0;
+	mClock.start();
+	mActive.store(true);
+	return true;
+}
+
+/** \internal Write the events as JSON. Timestamps of the format are microseconds. */
+bool TraceRecorder::stop()
+{
+	QMutexLocker lock(&mMutex);
+	if (!isActive())
+		return false;
+	mActive.store(false);
+
+	FILE* file = std::fopen(QFile::encodeName(mPath).constData(), "w");
+	if (!file)
+	{
+		qWarning() << "Cannot write trace file" << mPath;
+		return false;
+	}
+
+	const qint64 pid = QCoreApplication::applicationPid();
+	std::fprintf(file, "{\"traceEvents\":[\n");
+	for (size_t i = 0; i < mThreadNames.size(); ++i)
+	{
+		std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lld,\"tid\":%d,\"args\":{\"name\":\"",
+		             static_cast<long long>(pid), static_cast<int>(i + 1));
+		writeJsonString(file, mThreadNames[i].toUtf8().constData());
+		std::fprintf(file, "\"}},\n");
+	}
+	for (const Event& e : mEvents)
+	{
+		std::fprintf(file, "{\"name\":\"");
+		writeJsonString(file, e.name);
+		std::fprintf(file, "\",\"cat\":\"ssd\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%lld,\"tid\":%d",
+		             e.phase, e.begin / 1000.0, static_cast<long long>(pid), e.thread);
+		if (e.phase == 'X')
+			std::fprintf(file, ",\"dur\":%.3f,\"args\":{\"value\":%llu}},\n", (e.end - e.begin) / 1000.0,
+			             static_cast<unsigned long long>(e.id));
+		else
+		{
+			std::fprintf(file, ",\"id\":%llu,\"args\":{\"result\":\"", static_cast<unsigned long long>(e.id));
+			writeJsonString(file, e.result);
+			std::fprintf(file, "\"}},\n");
+		}
+	}
+	std::fprintf(file, "{\"name\":\"dropped events\",\"ph\":\"M\",\"pid\":%lld,\"args\":{\"count\":%lld}}\n]}\n",
+	             static_cast<long long>(pid), static_cast<long long>(mDropped));
+	return std::fclose(file) == 0;
+}
+
+void TraceRecorder::complete(const char* name, qint64 begin, qint64 end, quint64 id)
+{
+	record(Event { 'X', name, "", begin, end, id, 0 });
+}
+
+void TraceRecorder::valueBegin(quint64 id)
+{
+	record(Event { 'b', "value", "stamped", now(), 0, id, 0 });
+}
+
+void TraceRecorder::valueEnd(quint64 id, const char* result)
+{
+	record(Event { 'e', "value", result, now(), 0, id, 0 });
+}
+
+void TraceRecorder::record(const Event& event)
+{
+	QMutexLocker lock(&mMutex);
+	if (!isActive())
+		return;
+	if (mEvents.size() >= MaxEvents)
+	{
+		++mDropped;
+		return;
+	}
+	mEvents.push_back(event);
+	mEvents.back().thread = threadId();
+}
+
+/** \internal Returns a small id of the current thread, counted from 1 per trace. Called with the mutex locked. */
+int TraceRecorder::threadId()
+{
+	static thread_local int id = 0;
+	static thread_local int generation = 0;
+	if (generation != mGeneration)
+	{
+		QString name = QThread::currentThread()->objectName();
+		mThreadNames.push_back(name.isEmpty() ? QStringLiteral("Thread %1").arg(mThreadNames.size() + 1) : name);
+		id = static_cast<int>(mThreadNames.size());
+		generation = mGeneration;
+	}
+	return id;
+}
+
+#endif // SSD_ENABLE_TRACING
+
+bool SevenSegmentTrace::start(const QString& path)
+{
+#ifdef SSD_ENABLE_TRACING
+	return TraceRecorder::instance().start(path);
+#else
+	Q_UNUSED(path);
+	qWarning() << "Tracing is not compiled in (SSD_ENABLE_TRACING)";
+	return false;
+#endif
+}
+
+bool SevenSegmentTrace::stop()
+{
+#ifdef SSD_ENABLE_TRACING
+	return TraceRecorder::instance().stop();
+#else
+	return false;
+#endif
+}
+
+bool SevenSegmentTrace::isActive()
+{
+#ifdef SSD_ENABLE_TRACING
+	return TraceRecorder::instance().isActive();
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,52 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file sevensegmenttrace.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef SEVENSEGMENTTRACE_HPP
+#define SEVENSEGMENTTRACE_HPP
+
+#include <QString>
+
+/** Latency tracing of SevenSegmentDisplay values in the Chrome trace event format.
+ * Every value passed to setValue() or setString() is followed from the call through formatting, the change
+ * notification, the synchronization with the render thread and the node update to the swap of the frame that shows
+ * it. The trace opens in chrome://tracing or https://ui.perfetto.dev; each value is an async slice named "value".
+ * Tracing is only available in builds with SSD_ENABLE_TRACING (CMake option); other builds contain no tracing code.
+ * Setting the environment variable SSD_TRACE_FILE to a path starts tracing at the first display update and writes
+ * the file when the application exits. */
+class SevenSegmentTrace
+{
+public:
+	/** Start recording. Returns false if tracing is not compiled in or already running. */
+	static bool start(const QString& path);
+	/** Stop recording and write the trace file. Returns false if it could not be written. */
+	static bool stop();
+	static bool isActive();
+
+private:
+	SevenSegmentTrace() = delete;
+};
+
+#endif // SEVENSEGMENTTRACE_HPP
@@ -0,0 +1,135 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file timesource_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef TIMESOURCE_P_HPP_
+#define TIMESOURCE_P_HPP_
+
+#include "sevensegmentdisplay.hpp"
+#include "numberformat_p.hpp"
+
+#include <QElapsedTimer>
+#include <QTime>
+
+namespace
+{
+/** \internal Returns the time of the monotonic clock in milliseconds. */
+inline qint64 monotonicMsecs()
+{
+	QElapsedTimer timer;
+	timer.start();
+	return timer.msecsSinceReference();
+}
+} // namespace
+
+/** \internal Time shown by the clock, stopwatch and countdown modes.
+ * Plain data: the item keeps it on the GUI thread and the node samples a copy of it on the render thread. */
+struct TimeSource
+{
+	SevenSegmentDisplay::Mode mode = SevenSegmentDisplay::ModeValue;
+	bool running = false;
+	/* Monotonic time at which the elapsed time was zero, while running. */
+	qint64 reference = 0;
+	/* Elapsed time while stopped. */
+	qint64 elapsed = 0;
+	/* Duration of the countdown. */
+	qint64 countdown = 0;
+	/* Decimal places of the seconds. */
+	int precision = 0;
+
+	/** \internal Returns the elapsed time of the stopwatch or countdown at the monotonic time now. */
+	inline qint64 elapsedAt(qint64 now) const { return running ? now - reference : elapsed; }
+
+	/** \internal Start or stop the stopwatch or countdown at the monotonic time now. */
+	void setRunning(bool run, qint64 now)
+	{
+		if (run)
+			reference = now - elapsed;
+		else
+			elapsed = now - reference;
+		running = run;
+	}
+
+	/** \internal Reset the elapsed time to zero, keeping the stopwatch or countdown running or stopped. */
+	void restart(qint64 now)
+	{
+		reference = now;
+		elapsed = 0;
+	}
+
+	/** \internal Returns true if the countdown ran out. */
+	inline bool isFinished(qint64 now) const
+	{
+		return mode == SevenSegmentDisplay::ModeCountdown && running && elapsedAt(now) >= countdown;
+	}
+
+	/** \internal Returns the time to show in milliseconds: the time of day, the elapsed or the remaining time.
+	 * The remaining time is rounded up to the shown decimal places, so zero is only shown when the countdown ran out. */
+	qint64 shownAt(qint64 now) const
+	{
+		switch (mode)
+		{
+		case SevenSegmentDisplay::ModeClock:
+			return QTime::currentTime().msecsSinceStartOfDay();
+		case SevenSegmentDisplay::ModeStopwatch:
+			return qMax(elapsedAt(now), qint64(0));
+		case SevenSegmentDisplay::ModeCountdown:
+		{
+			qint64 remaining = qBound(qint64(0), countdown - elapsedAt(now), countdown);
+			return (remaining + resolution() - 1) / resolution() * resolution();
+		}
+		default:
+			return 0;
+		}
+	}
+
+	/** \internal Returns the milliseconds until the shown time changes next or -1 if it does not change anymore. */
+	qint64 untilChange(qint64 now) const
+	{
+		if (mode == SevenSegmentDisplay::ModeValue || (mode != SevenSegmentDisplay::ModeClock && !running))
+			return -1;
+
+		if (mode == SevenSegmentDisplay::ModeCountdown)
+		{
+			qint64 remaining = countdown - elapsedAt(now);
+			if (remaining <= 0)
+				return -1;
+			qint64 rest = remaining % resolution();
+			return rest ? rest : resolution();
+		}
+
+		qint64 shown = (mode == SevenSegmentDisplay::ModeClock) ? shownAt(now) : qMax(elapsedAt(now), qint64(0));
+		return resolution() - shown % resolution();
+	}
+
+private:
+	/** \internal Returns the milliseconds of the last shown decimal place. */
+	inline qint64 resolution() const
+	{
+		return static_cast<qint64>(1000 / lutPow10[qBound(0, precision, maxTimePrecision)]);
+	}
+};
+
+#endif /* TIMESOURCE_P_HPP_ */
@@ -0,0 +1,129 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file tracing_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef TRACING_P_HPP_
+#define TRACING_P_HPP_
+
+#ifdef SSD_ENABLE_TRACING
+
+#include <atomic>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+
+/** \internal Collects trace events of all threads in memory until the trace is stopped. */
+class TraceRecorder
+{
+public:
+	static TraceRecorder& instance();
+
+	inline bool isActive() const { return mActive.load(std::memory_order_relaxed); }
+
+	bool start(const QString& path);
+	bool stop();
+
+	/** \internal Nanoseconds since the start of the trace. */
+	inline qint64 now() const { return mClock.nsecsElapsed(); }
+	/** \internal Returns a new id for a traced value. Never 0. */
+	inline quint64 nextId() { return ++mLastId; }
+
+	/** \internal Record a span of the current thread. */
+	void complete(const char* name, qint64 begin, qint64 end, quint64 id);
+	/** \internal Begin or end the lifetime of a value. result names the fate of the value on the end. */
+	void valueBegin(quint64 id);
+	void valueEnd(quint64 id, const char* result);
+
+private:
+	TraceRecorder();
+	~TraceRecorder();
+
+	/* Phase of the Chrome trace format: complete span, async begin or async end. Strings are literals. */
+	struct Event
+	{
+		char phase;
+		const char* name;
+		const char* result;
+		qint64 begin;
+		qint64 end;
+		quint64 id;
+		int thread;
+	};
+
+	void record(const Event& event);
+	int threadId();
+
+	/* Bounds the memory of a forgotten trace. */
+	enum { MaxEvents = 4 * 1024 * 1024 };
+
+	std::atomic<bool> mActive;
+	std::atomic<quint64> mLastId;
+	QElapsedTimer mClock;
+	QMutex mMutex;
+	QString mPath;
+	std::vector<Event> mEvents;
+	std::vector<QString> mThreadNames;
+	/* Invalidates the thread ids of the previous trace. */
+	int mGeneration = 0;
+	qint64 mDropped = 0;
+};
+
+/** \internal Records the scope it lives in as span. */
+class TraceSpan
+{
+public:
+	TraceSpan(const char* name, quint64 id):
+		mName(name), mId(id), mBegin(TraceRecorder::instance().isActive() ? TraceRecorder::instance().now() : -1)
+	{
+	}
+	~TraceSpan()
+	{
+		if (mBegin >= 0)
+			TraceRecorder::instance().complete(mName, mBegin, TraceRecorder::instance().now(), mId);
+	}
+
+private:
+	Q_DISABLE_COPY(TraceSpan)
+
+	const char* mName;
+	quint64 mId;
+	qint64 mBegin;
+};
+
+/* Record the enclosing scope as span of the value with the given id (0 if none). */
+#define SSD_TRACE_SPAN(name, id) TraceSpan traceSpan(name, id)
+/* Execute a statement only while tracing. */
+#define SSD_TRACE(statement) do { if (Q_UNLIKELY(TraceRecorder::instance().isActive())) { statement; } } while (0)
+
+#else
+
+#define SSD_TRACE_SPAN(name, id) do {} while (0)
+#define SSD_TRACE(statement) do {} while (0)
+
+#endif // SSD_ENABLE_TRACING
+
+#endif /* TRACING_P_HPP_ */
@@ -0,0 +1,63 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file valueanimation_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef VALUEANIMATION_P_HPP_
+#define VALUEANIMATION_P_HPP_
+
+#include <QEasingCurve>
+#include <QtGlobal>
+
+/** \internal Transition of the shown value started by SevenSegmentDisplay::animateTo().
+ * Plain data: the item keeps it on the GUI thread and the node interpolates a copy of it on the render thread. */
+struct ValueAnimation
+{
+	bool active = false;
+	/* Tells the completion of an animation from the one of a superseded animation. */
+	int serial = 0;
+	double from = 0;
+	double to = 0;
+	/* Monotonic time of the start. */
+	qint64 start = 0;
+	int duration = 0;
+	QEasingCurve easing;
+	/* Decimal places of the interpolated values. */
+	int precision = 0;
+
+	/** \internal Returns the progress at the monotonic time now in the range of 0 to 1. */
+	inline qreal progressAt(qint64 now) const
+	{
+		return (duration > 0) ? qBound(qreal(0), qreal(now - start) / duration, qreal(1)) : qreal(1);
+	}
+
+	/** \internal Returns the interpolated value at the monotonic time now. The end value is exact. */
+	inline double valueAt(qint64 now) const
+	{
+		qreal progress = progressAt(now);
+		return (progress < 1) ? from + (to - from) * easing.valueForProgress(progress) : to;
+	}
+};
+
+#endif /* VALUEANIMATION_P_HPP_ */
@@ -0,0 +1,88 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file vertextransform_p.hpp
+ *
+ * \date 15.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#ifndef VERTEXTRANSFORM_P_HPP_
+#define VERTEXTRANSFORM_P_HPP_
+
+#include <QtGlobal>
+#include <QSGGeometry>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SSD_VERTEXTRANSFORM_SSE2
+#endif
+
+namespace
+{
+/** \internal Scale and translate vertices given as separate x and y arrays into a Point2D vertex buffer.
+ * Only positions that differ from the current content of the buffer are considered as change, so unchanged layouts
+ * do not mark the geometry dirty. Uses SSE2 where available.
+ * \return True if at least one position changed.
+ */
+inline bool scaleTranslate(const float* xs, const float* ys, int count, float sx, float sy, float dx, float dy,
+                           QSGGeometry::Point2D* out)
+{
+	int i = 0;
+	bool changed = false;
+
+#ifdef SSD_VERTEXTRANSFORM_SSE2
+	const __m128 scaleX = _mm_set1_ps(sx);
+	const __m128 scaleY = _mm_set1_ps(sy);
+	const __m128 transX = _mm_set1_ps(dx);
+	const __m128 transY = _mm_set1_ps(dy);
+	__m128 differs = _mm_setzero_ps();
+	float* data = &out->x;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(xs + i), scaleX), transX);
+		__m128 y = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(ys + i), scaleY), transY);
+		// Interleave to x0 y0 x1 y1 and x2 y2 x3 y3
+		__m128 lo = _mm_unpacklo_ps(x, y);
+		__m128 hi = _mm_unpackhi_ps(x, y);
+		differs = _mm_or_ps(differs, _mm_cmpneq_ps(lo, _mm_loadu_ps(data + 2 * i)));
+		differs = _mm_or_ps(differs, _mm_cmpneq_ps(hi, _mm_loadu_ps(data + 2 * i + 4)));
+		_mm_storeu_ps(data + 2 * i, lo);
+		_mm_storeu_ps(data + 2 * i + 4, hi);
+	}
+	changed = _mm_movemask_ps(differs) != 0;
+#endif
+
+	for (; i < count; ++i)
+	{
+		float x = xs[i] * sx + dx;
+		float y = ys[i] * sy + dy;
+		if (x != out[i].x || y != out[i].y)
+		{
+			out[i].set(x, y);
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+} // namespace
+
+#endif /* VERTEXTRANSFORM_P_HPP_ */
@@ -26,12 +26,17 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <gui/sevensegmentdisplay.hpp>
+#include <gui/sevensegmentdisplaygrid.hpp>
+#include <gui/sevensegmentstats.hpp>
 
 int main(int argc, char* argv[])
 {
 	QGuiApplication app(argc, argv);
 
 	qmlRegisterType<SevenSegmentDisplay>("de.nisble", 1, 0, "SevenSegmentDisplay");
+	qmlRegisterType<SevenSegmentDisplayGrid>("de.nisble", 1, 0, "SevenSegmentDisplayGrid");
+	qmlRegisterUncreatableType<SevenSegmentStats>("de.nisble", 1, 0, "SevenSegmentStats",
+	                                              QStringLiteral("Use SevenSegmentDisplay.stats"));
 
 	QQmlApplicationEngine engine;
 	engine.load(QUrl(QStringLiteral("qrc:/qml/main.qml")));
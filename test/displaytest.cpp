@@ -0,0 +1,804 @@
+/* Copyright (C) 2015  Moritz Nisblé <moritz.nisble@gmx.de>
+ *
+ * This file is part of SevenSegmentsDisplay.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/**
+ * \file displaytest.cpp
+ *
+ * Unit tests of the display pipeline from SevenSegmentDisplay down to the element nodes.
+ * No window or OpenGL context is needed; the nodes are updated like on the render thread but never rendered.
+ *
+ * \date 16.10.2026
+ * \author Moritz Nisblé moritz.nisble@gmx.de
+ */
+
+#include <gui/sevensegmentdisplay_p.hpp>
+#include <gui/sevensegmentrenderer.hpp>
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <QGuiApplication>
+#include <QMutex>
+#include <QQuickWindow>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QtTest>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace
+{
+/* Count of heap allocations done through the global operator new. */
+std::atomic<qint64> allocationCount(0);
+
+const int digitCounts[] = { 1, 4, 8, 32, 128 };
+const char* const renderModeNames[] = { "nodes", "vertexcolor", "shader", "atlas" };
+const QRectF bounds(0, 0, 1024, 64);
+/** Bytes of heap in use, including memory allocated with malloc() directly (e.g. vertex buffers).
+ * Returns -1 if the C library gives no access to it. */
+qint64 heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	return qint64(mallinfo2().uordblks);
+#elif defined(__GLIBC__)
+	return qint64(static_cast<unsigned int>(mallinfo().uordblks));
+#else
+	return -1;
+#endif
+}
+} // namespace
+
+void* operator new(std::size_t size)
+{
+	++allocationCount;
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) Q_DECL_NOTHROW
+{
+	std::free(p);
+}
+
+/* Renders a list of strings on the pool it runs on. */
+class BatchRenderTask: public QRunnable
+{
+public:
+	BatchRenderTask(const SevenSegmentRenderer& renderer, const QStringList& strings, QVector<QImage>& images,
+	                QThreadPool& pool, std::atomic<int>& truncated):
+		mRenderer(renderer), mStrings(strings), mImages(images), mPool(pool), mTruncated(truncated)
+	{
+	}
+
+	void run() { mTruncated = mRenderer.render(mStrings, mImages, &mPool); }
+
+private:
+	const SevenSegmentRenderer& mRenderer;
+	const QStringList& mStrings;
+	QVector<QImage>& mImages;
+	QThreadPool& mPool;
+	std::atomic<int>& mTruncated;
+};
+
+/* Exposes the synchronization with the scene graph, so a test can play the render thread. */
+class SyncedDisplay: public SevenSegmentDisplay
+{
+public:
+	QSGNode* sync(QSGNode* oldRoot) { return updatePaintNode(oldRoot, nullptr); }
+};
+
+class DisplayTest: public QObject
+{
+	Q_OBJECT
+
+private slots:
+	/* Heap usage per digit of each render mode. The batch modes must stay below the
+	 * node mode, the shader mode by an order of magnitude. */
+	void memoryPerDigit()
+	{
+		if (heapInUse() < 0)
+			QSKIP("Heap usage can only be measured with glibc");
+
+		const int digits = 1024;
+		qint64 measured[3];
+		for (int mode = SevenSegmentDisplay::RenderSegmentNodes; mode <= SevenSegmentDisplay::RenderShader; ++mode)
+		{
+			qint64 before = heapInUse();
+			DisplayNode* node = new DisplayNode;
+			prepare(*node, digits, mode);
+			node->setString(pattern(digits, '8'));
+			node->update(bounds);
+			measured[mode] = heapInUse() - before;
+
+			qDebug() << renderModeNames[mode] << "bytes per digit: measured" << double(measured[mode]) / digits
+			         << "reported" << double(node->getMemoryUsage()) / digits;
+			delete node;
+		}
+
+		QVERIFY(measured[SevenSegmentDisplay::RenderVertexColor] < measured[SevenSegmentDisplay::RenderSegmentNodes]);
+		QVERIFY(measured[SevenSegmentDisplay::RenderShader] * 10 <= measured[SevenSegmentDisplay::RenderSegmentNodes]);
+	}
+
+	/* The reported memory is only summed up again when the node tree changes, but follows every such change. */
+	void memoryTracksNodeTree()
+	{
+		DisplayNode node;
+		prepare(node, 8, SevenSegmentDisplay::RenderSegmentNodes);
+		// Both text buffers have their final capacity after two strings
+		node.setString(pattern(8, '1'));
+		node.setString(pattern(8, '8'));
+		node.update(bounds);
+		qint64 eight = node.getMemoryUsage();
+		QVERIFY(eight > 0);
+
+		node.setString(pattern(8, '1'));
+		node.update(bounds);
+		QCOMPARE(node.getMemoryUsage(), eight);
+
+		node.setDigitCount(16);
+		node.update(bounds);
+		QVERIFY(node.getMemoryUsage() > eight);
+
+		node.setRenderMode(SevenSegmentDisplay::RenderShader);
+		node.update(bounds);
+		QVERIFY(node.getMemoryUsage() < eight);
+	}
+
+	/* RenderSegmentNodes builds a node per digit and per element, the batch modes a single geometry node. */
+	void nodeCount_data()
+	{
+		QTest::addColumn<int>("mode");
+		QTest::addColumn<int>("nodes");
+		QTest::addColumn<int>("geometryNodes");
+		QTest::newRow("nodes") << int(SevenSegmentDisplay::RenderSegmentNodes) << 8 + 8 * elementCount
+		                       << 8 * elementCount;
+		QTest::newRow("vertexcolor") << int(SevenSegmentDisplay::RenderVertexColor) << 1 << 1;
+		QTest::newRow("shader") << int(SevenSegmentDisplay::RenderShader) << 1 << 1;
+		QTest::newRow("atlas") << int(SevenSegmentDisplay::RenderAtlas) << 1 << 1;
+	}
+	void nodeCount()
+	{
+		QFETCH(int, mode);
+		QFETCH(int, nodes);
+		QFETCH(int, geometryNodes);
+
+		DisplayNode node;
+		prepare(node, 8, mode);
+		node.setString(pattern(8, '8'));
+		node.update(bounds);
+		QCOMPARE(countNodes(&node, false), nodes);
+		QCOMPARE(countNodes(&node, true), geometryNodes);
+	}
+
+	/* The elements of all displays of a window reference one material per color. The batch renderer merges
+	 * geometry of equal material state, so the displays need as many batches as there are colors. */
+	void materialBatches()
+	{
+		QSharedPointer<MaterialCache> cache(new MaterialCache);
+		std::vector<std::unique_ptr<DisplayNode>> nodes;
+		for (int i = 0; i < 4; ++i)
+		{
+			nodes.emplace_back(new DisplayNode);
+			nodes.back()->setMaterialCache(cache);
+			prepare(*nodes.back(), 8, SevenSegmentDisplay::RenderSegmentNodes);
+			nodes.back()->setValue(i * 1234.5, 1);
+			nodes.back()->update(bounds);
+		}
+		QCOMPARE(cache->size(), 2);
+		QCOMPARE(countMaterials(nodes), 2);
+
+		// Another color adds one batch, the former materials are shared by the others
+		nodes[0]->setOnColor(QColor("red"));
+		nodes[0]->update(bounds);
+		QCOMPARE(cache->size(), 3);
+		QCOMPARE(countMaterials(nodes), 3);
+	}
+
+	/* The cache of a window is shared while displays use it and unregistered with the last of them, so windows
+	 * created at the address of a destroyed one start with a new cache. */
+	void materialCacheLifetime()
+	{
+		QQuickWindow window;
+		int count = MaterialCache::count();
+		{
+			QSharedPointer<MaterialCache> cache = MaterialCache::forWindow(&window);
+			QCOMPARE(MaterialCache::forWindow(&window).data(), cache.data());
+			QCOMPARE(MaterialCache::count(), count + 1);
+		}
+		QCOMPARE(MaterialCache::count(), count);
+	}
+
+	/* A value must not allocate once the display is set up: neither in setValue(), nor in the synchronization
+	 * and the update of the node. */
+	void setValueAllocations_data() { digitCountData(); }
+	void setValueAllocations()
+	{
+		QFETCH(int, digits);
+
+		QQuickWindow window;
+		SyncedDisplay display;
+		display.setParentItem(window.contentItem());
+		display.setDigitCount(digits);
+		display.setPrecision(2);
+		// Both text buffers of the item and the node have their final capacity after two values
+		display.setValue(1);
+		QSGNode* root = display.sync(nullptr);
+		display.setValue(2);
+		root = display.sync(root);
+
+		const int iterations = 10000;
+		qint64 before = allocationCount;
+		for (int i = 0; i < iterations; ++i)
+		{
+			display.setValue(i * 0.37);
+			root = display.sync(root);
+		}
+		qint64 allocations = allocationCount - before;
+
+		qDebug() << "Allocations per value:" << double(allocations) / iterations;
+		QCOMPARE(allocations, qint64(0));
+		delete root;
+	}
+
+	/* Rendering a list from a thread of the pool it renders on must not wait for that pool. */
+	void rendererOnOwnPool()
+	{
+		QThreadPool pool;
+		pool.setMaxThreadCount(1);
+
+		SevenSegmentRenderer renderer;
+		QStringList strings;
+		for (int i = 0; i < 64; ++i)
+			strings << QString::number(i);
+		QVector<QImage> images;
+		std::atomic<int> truncated(-1);
+		pool.start(new BatchRenderTask(renderer, strings, images, pool, truncated));
+		QVERIFY(pool.waitForDone(10000));
+		QCOMPARE(int(truncated), 0);
+		QCOMPARE(images.size(), strings.size());
+	}
+
+	/* Values between two updates are combined and counted as dropped. */
+	void coalesceAggregates()
+	{
+		SevenSegmentDisplay display;
+		display.setDigitCount(8);
+		display.setPrecision(1);
+
+		const SevenSegmentDisplay::Coalesce modes[] = { SevenSegmentDisplay::CoalesceLatest,
+		                                                SevenSegmentDisplay::CoalesceMinimum,
+		                                                SevenSegmentDisplay::CoalesceMaximum,
+		                                                SevenSegmentDisplay::CoalesceMean };
+		const double expected[] = { 3, 1, 5, 3 };
+		for (int i = 0; i < 4; ++i)
+		{
+			display.setCoalesce(modes[i]);
+			for (double v : { 2.0, 5.0, 1.0, 4.0, 3.0 })
+				display.setValue(v);
+			// Leaving the mode shows the pending aggregate
+			display.setCoalesce(SevenSegmentDisplay::CoalesceNone);
+			QCOMPARE(display.getValue(), expected[i]);
+		}
+		QCOMPARE(display.getDroppedValueCount(), qint64(4 * 4));
+	}
+
+	/* Strings shorter than the digit count are right justified; a dot is merged into the preceding digit. */
+	void shortStrings_data()
+	{
+		QTest::addColumn<QString>("string");
+		QTest::addColumn<QString>("shown");
+		QTest::addColumn<QByteArray>("codes");
+		QTest::newRow("dot") << QStringLiteral("1.5") << QStringLiteral("   1.5") << QByteArray("\x00\x00\x00\x86\x6d", 5);
+		QTest::newRow("digits") << QStringLiteral("12") << QStringLiteral("   12") << QByteArray("\x00\x00\x00\x06\x5b", 5);
+		QTest::newRow("minus") << QStringLiteral("-3") << QStringLiteral("   -3") << QByteArray("\x00\x00\x00\x40\x4f", 5);
+	}
+	void shortStrings()
+	{
+		QFETCH(QString, string);
+		QFETCH(QString, shown);
+		QFETCH(QByteArray, codes);
+
+		DisplayNode node;
+		node.setDigitCount(5);
+		node.setString(string);
+		QCOMPARE(node.getString(), shown);
+		for (int i = 0; i < 5; ++i)
+			QCOMPARE(int(node.getCode(i)), int(quint8(codes[i])));
+
+		SevenSegmentDisplay display;
+		display.setDigitCount(5);
+		display.setString(string);
+		QCOMPARE(display.getString(), shown);
+	}
+
+	/* A colon lights the colon after its digit and a dot the decimal point, so both look different. */
+	void colonAndDot()
+	{
+		DisplayNode node;
+		node.setDigitCount(4);
+		node.setString(QStringLiteral("12:34"));
+		QCOMPARE(int(node.getCode(1)), int(segmentCode('2') | colonBit));
+		node.setString(QStringLiteral("12.34"));
+		QCOMPARE(int(node.getCode(1)), int(segmentCode('2') | dotBit));
+
+		SevenSegmentRenderer renderer;
+		QImage colon;
+		QImage dot;
+		renderer.render(QStringLiteral("12:34"), colon);
+		renderer.render(QStringLiteral("12.34"), dot);
+		QVERIFY(colon != dot);
+
+		// Segment masks have no colon
+		SevenSegmentDisplay display;
+		display.setDigitCount(2);
+		display.setString(QStringLiteral("1:2"));
+		QCOMPARE(display.getSegments(), QByteArray("\x06\x5b", 2));
+	}
+
+	/* Integers are exact beyond 2^53 and shown in every radix. */
+	void integerFormats()
+	{
+		SevenSegmentDisplay display;
+		display.setDigitCount(20);
+
+		display.setInteger((Q_INT64_C(1) << 53) + 1);
+		QCOMPARE(display.getString().trimmed(), QStringLiteral("9007199254740993"));
+		display.setInteger(std::numeric_limits<qint64>::min());
+		QCOMPARE(display.getString().trimmed(), QStringLiteral("-9223372036854775808"));
+
+		display.setRadix(16);
+		display.setInteger(0xbeef);
+		QCOMPARE(display.getString().trimmed(), QStringLiteral("BEEF"));
+		QCOMPARE(display.getValue(), double(0xbeef));
+		display.setRadix(2);
+		QCOMPARE(display.getString().trimmed(), QStringLiteral("1011111011101111"));
+
+		display.setFixedPoint(-12345, -2);
+		QCOMPARE(display.getString().trimmed(), QStringLiteral("-123.45"));
+		QCOMPARE(display.getValue(), -123.45);
+		display.setFixedPoint(5, -3);
+		QCOMPARE(display.getString().trimmed(), QStringLiteral("0.005"));
+		display.setFixedPoint(12, 3);
+		QCOMPARE(display.getString().trimmed(), QStringLiteral("12000"));
+	}
+
+	/* A bulk update from QML slices the masks in list order and keeps them across a digit count change. */
+	void bulkSegments()
+	{
+		SevenSegmentDisplay left;
+		SevenSegmentDisplay right;
+		left.setDigitCount(2);
+		right.setDigitCount(3);
+		QObject other;
+
+		QVariantList displays;
+		displays << QVariant::fromValue<QObject*>(&left) << QVariant::fromValue<QObject*>(&other)
+		         << QVariant::fromValue<QObject*>(&right);
+		QTest::ignoreMessage(QtWarningMsg, QRegularExpression("Not a SevenSegmentDisplay"));
+		right.setSegmentsOf(displays, QByteArray("\x76\x79\x38\x73", 4));
+		QCOMPARE(left.getSegments(), QByteArray("\x76\x79", 2));
+		// Missing masks leave the leading digits blank
+		QCOMPARE(right.getSegments(), QByteArray("\x00\x38\x73", 3));
+
+		right.setDigitCount(4);
+		QCOMPARE(right.getSegments(), QByteArray("\x00\x00\x38\x73", 4));
+	}
+
+	/* A counter incrementing in the last digit must only touch that digit. */
+	void touchedDigits_data() { renderModeData(); }
+	void touchedDigits()
+	{
+		QFETCH(int, digits);
+		QFETCH(int, mode);
+		if (digits < 2)
+			QSKIP("The counter needs two digits");
+
+		DisplayNode node;
+		prepare(node, digits, mode);
+		node.setValue(10, 0);
+		node.update(bounds);
+
+		for (int i = 11; i < 20; ++i)
+		{
+			node.setValue(i, 0);
+			node.update(bounds);
+			QCOMPARE(node.getTouchedDigitCount(), 1);
+		}
+	}
+
+	/* The time modes format the sampled time and a tick only touches the changed digit. */
+	void timeModes()
+	{
+		DisplayNode node;
+		prepare(node, 8, SevenSegmentDisplay::RenderVertexColor);
+
+		TimeSource source;
+		source.mode = SevenSegmentDisplay::ModeStopwatch;
+		source.elapsed = 3723456;
+		source.precision = 2;
+		node.setTimeSource(source);
+		QCOMPARE(node.getString(), QStringLiteral("01:02:03.45"));
+		// The colons differ from the decimal point
+		QCOMPARE(int(node.getCode(1)), int(segmentCode('1') | colonBit));
+		QCOMPARE(int(node.getCode(3)), int(segmentCode('2') | colonBit));
+		QCOMPARE(int(node.getCode(5)), int(segmentCode('3') | dotBit));
+		node.update(bounds);
+
+		source.elapsed += 10;
+		node.setTimeSource(source);
+		node.update(bounds);
+		QCOMPARE(node.getString(), QStringLiteral("01:02:03.46"));
+		QCOMPARE(node.getTouchedDigitCount(), 1);
+
+		// The remaining time is rounded up
+		source.mode = SevenSegmentDisplay::ModeCountdown;
+		source.countdown = 10000;
+		source.elapsed = 2505;
+		node.setTimeSource(source);
+		QCOMPARE(node.getString(), QStringLiteral("00:00:07.50"));
+		QCOMPARE(source.untilChange(0), qint64(-1));
+		source.running = true;
+		source.reference = 0;
+		QCOMPARE(source.untilChange(2505), qint64(5));
+		QVERIFY(source.isFinished(10000));
+	}
+
+	/* Animations interpolate along the easing curve and end exactly on the end value. */
+	void valueAnimation()
+	{
+		ValueAnimation animation;
+		animation.from = 10;
+		animation.to = 20;
+		animation.start = 1000;
+		animation.duration = 500;
+		QCOMPARE(animation.valueAt(1000), 10.0);
+		QCOMPARE(animation.valueAt(1250), 15.0);
+		QCOMPARE(animation.valueAt(1500), 20.0);
+		QCOMPARE(animation.valueAt(9999), 20.0);
+
+		// A finished animation shows its end value on the first sample
+		DisplayNode node;
+		prepare(node, 4, SevenSegmentDisplay::RenderVertexColor);
+		QSignalSpy finished(&node, SIGNAL(animationFinished(int)));
+		animation.active = true;
+		animation.serial = 7;
+		animation.start = monotonicMsecs() - animation.duration;
+		node.setAnimation(animation);
+		QCOMPARE(node.getString(), QStringLiteral("  20"));
+		QCOMPARE(finished.count(), 1);
+		QCOMPARE(finished.first().first().toInt(), 7);
+	}
+
+	/* The counters reflect what an update did. */
+	void statsCounters()
+	{
+#ifndef SSD_ENABLE_STATS
+		QSKIP("Render statistics are not compiled in");
+#endif
+		RenderCounters counters;
+		DisplayNode node;
+		prepare(node, 4, SevenSegmentDisplay::RenderVertexColor);
+		node.setValue(10, 0);
+		node.update(bounds);
+		node.setCounters(&counters);
+
+		// A counter step in the last digit: no layout, one digit
+		node.setValue(11, 0);
+		node.update(bounds);
+		QCOMPARE(qint64(counters.geometryFrames), qint64(0));
+		QCOMPARE(qint64(counters.segmentFrames), qint64(1));
+		QCOMPARE(qint64(counters.touchedDigits), qint64(1));
+		QVERIFY(counters.touchedVertices > 0);
+
+		node.setDigitSize(30);
+		node.update(bounds);
+		QCOMPARE(qint64(counters.geometryFrames), qint64(1));
+		QVERIFY(counters.updateNanoseconds > 0);
+	}
+
+	/* The item detects an overflow once; the node shows the kept text without truncating it again. */
+	void overflowOnce()
+	{
+		QQuickWindow window;
+		SyncedDisplay display;
+		display.setParentItem(window.contentItem());
+		display.getStats()->setEnabled(true);
+		display.setDigitCount(2);
+
+		QSignalSpy overflows(&display, SIGNAL(overflow()));
+		display.setString(QStringLiteral("123.4"));
+		QCOMPARE(display.getString(), QStringLiteral("12"));
+		QCOMPARE(overflows.count(), 1);
+
+		QSGNode* root = display.sync(nullptr);
+		QCOMPARE(static_cast<DisplayNode*>(root)->getString(), display.getString());
+		QCOMPARE(overflows.count(), 1);
+#ifdef SSD_ENABLE_STATS
+		QCOMPARE(display.getStats()->getOverflows(), qint64(1));
+#endif
+		delete root;
+	}
+
+	/* Producers publish concurrently while a consumer takes samples like once per frame.
+	 * Every taken sample must be consistent and newer than the previous one of the same producer.
+	 * Build with -fsanitize=thread to check the feed for data races. */
+	void feedStress()
+	{
+		const int producerCount = 4;
+		const int iterations = 100000;
+
+		SevenSegmentFeed feed;
+		std::atomic<int> running(producerCount);
+		std::vector<std::thread> producers;
+		for (int p = 0; p < producerCount; ++p)
+		{
+			producers.emplace_back([&feed, &running, p]()
+			{
+				char text[SevenSegmentFeed::TextCapacity];
+				for (int i = 1; i <= iterations; ++i)
+				{
+					// Numbers carry odd, texts even sequence numbers
+					if (i & 1)
+						feed.setValue(p * 1e6 + i);
+					else
+						feed.setText(text, std::snprintf(text, sizeof(text), "%d:%d", p, i));
+				}
+				--running;
+			});
+		}
+
+		int last[producerCount] = {};
+		int inconsistent = 0;
+		int outdated = 0;
+		quint64 taken = 0;
+		SevenSegmentFeed::Sample sample;
+		bool done = false;
+		while (!done)
+		{
+			done = !running;
+			if (!feed.take(sample))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			++taken;
+
+			int p = -1;
+			int i = -1;
+			if (sample.isText)
+			{
+				QByteArray text(sample.text, sample.size);
+				if (std::sscanf(text.constData(), "%d:%d", &p, &i) != 2 || (i & 1))
+					p = -1;
+			}
+			else
+			{
+				p = static_cast<int>(sample.value / 1e6);
+				i = static_cast<int>(sample.value - p * 1e6);
+				if (!(i & 1))
+					p = -1;
+			}
+
+			if (p < 0 || p >= producerCount)
+				++inconsistent;
+			else if (i <= last[p])
+				++outdated;
+			else
+				last[p] = i;
+		}
+
+		for (std::thread& t : producers)
+			t.join();
+
+		qDebug() << "Taken samples:" << taken << "dropped:" << feed.getDroppedCount();
+		QCOMPARE(inconsistent, 0);
+		QCOMPARE(outdated, 0);
+		// Values of producers that lapped all slots are not counted
+		QVERIFY(taken + feed.getDroppedCount() <= quint64(producerCount) * iterations);
+		QVERIFY(taken > 0);
+	}
+
+	/* The GUI thread changes properties all the time while another thread plays the threaded
+	 * render loop. The GUI thread is blocked while the item synchronizes its node; rendering reads the node
+	 * concurrently to the GUI thread. Build with -fsanitize=thread to check the item for data races. */
+	void renderLoopStress()
+	{
+		const int iterations = 20000;
+
+		QQuickWindow window;
+		SyncedDisplay display;
+		display.setParentItem(window.contentItem());
+		display.setPrecision(2);
+
+		// Held by the GUI thread while it runs, by the render thread while it synchronizes
+		QMutex gui;
+		std::atomic<bool> done(false);
+		int frames = 0;
+		int mismatches = 0;
+		std::thread render([&]()
+		{
+			QSGNode* root = nullptr;
+			while (!done)
+			{
+				QString expected;
+				{
+					QMutexLocker lock(&gui);
+					root = display.sync(root);
+					expected = display.getString();
+				}
+
+				// Render: read the node and its geometry without blocking the GUI thread
+				DisplayNode* node = static_cast<DisplayNode*>(root);
+				if (node->getString() != expected)
+					++mismatches;
+				int vertices = 0;
+				for (QSGNode* child = node->firstChild(); child; child = child->nextSibling())
+					if (child->type() == QSGNode::GeometryNodeType)
+						vertices += static_cast<QSGGeometryNode*>(child)->geometry()->vertexCount();
+				Q_UNUSED(vertices);
+				++frames;
+			}
+			delete root;
+		});
+
+		const QColor colors[] = { QColor("green"), QColor("red"), QColor("blue") };
+		for (int i = 0; i < iterations; ++i)
+		{
+			QMutexLocker lock(&gui);
+			display.setValue(i * 0.37);
+			display.setDigitCount(4 + i % 5);
+			display.setDigitSize(20 + i % 7);
+			display.setOnColor(colors[i % 3]);
+			display.setHorizontalAlignment((i & 1) ? SevenSegmentDisplay::AlignCenter : SevenSegmentDisplay::AlignLeft);
+			display.setRenderMode(static_cast<SevenSegmentDisplay::RenderMode>(i % 3));
+			display.setAntialiasing(i & 2);
+			if (i % 100 == 0)
+				display.setString(QStringLiteral("--:--"));
+		}
+		done = true;
+		render.join();
+
+		qDebug() << "Frames:" << frames;
+		QVERIFY(frames > 0);
+		QCOMPARE(mismatches, 0);
+	}
+
+	/* The glyphs are laid out in rows separated by a transparent gap. */
+	void glyphAtlasLayout()
+	{
+		GlyphAtlasKey key;
+		key.pixelSize = 24;
+		key.on = QColor("green").rgba();
+		key.off = QColor("gray").rgba();
+		key.antialiasing = true;
+
+		QImage image = GlyphAtlas::rasterize(key);
+		QCOMPARE(image.height(), GlyphAtlas::Rows * (key.pixelSize + GlyphAtlas::Gap) - GlyphAtlas::Gap);
+		for (int x = 0; x < image.width(); ++x)
+			QCOMPARE(image.pixel(x, key.pixelSize), QRgb(0));
+		// Columns are separated alike
+		const int glyphWidth = (image.width() + GlyphAtlas::Gap) / GlyphAtlas::Columns - GlyphAtlas::Gap;
+		QCOMPARE(glyphWidth, int(std::ceil(baseDigitWidth * key.pixelSize / baseDigitHeight)));
+		for (int y = 0; y < image.height(); ++y)
+			QCOMPARE(image.pixel(glyphWidth, y), QRgb(0));
+
+		// The largest atlas fits a 2048 pixel texture
+		key.pixelSize = maxAtlasPixelSize;
+		image = GlyphAtlas::rasterize(key);
+		QVERIFY(image.width() <= 2048 && image.height() <= 2048);
+	}
+
+	/* Without a window there is no atlas, so the node must not be drawn with a null texture. */
+	void atlasNodeWithoutWindow()
+	{
+		AtlasNode node(nullptr);
+		node.setDigitCount(4);
+		node.updateGeometry(0, QRectF(0, 0, 20, 40), 1);
+		node.display(0, segmentCode('8'), segmentCode('8'));
+		QVERIFY(node.isSubtreeBlocked());
+	}
+
+private:
+	static void digitCountData()
+	{
+		QTest::addColumn<int>("digits");
+		for (int digits : digitCounts)
+			QTest::newRow(QByteArray::number(digits).constData()) << digits;
+	}
+
+	static void renderModeData()
+	{
+		QTest::addColumn<int>("digits");
+		QTest::addColumn<int>("mode");
+
+		for (int mode = SevenSegmentDisplay::RenderSegmentNodes; mode <= SevenSegmentDisplay::RenderShader; ++mode)
+			for (int digits : digitCounts)
+			{
+				QByteArray name = QByteArray(renderModeNames[mode]) + '/' + QByteArray::number(digits);
+				QTest::newRow(name.constData()) << digits << mode;
+			}
+	}
+
+	/** Returns the count of nodes below the root, optionally only the geometry nodes. */
+	static int countNodes(const QSGNode* root, bool geometryOnly)
+	{
+		int count = 0;
+		for (const QSGNode* child = root->firstChild(); child; child = child->nextSibling())
+		{
+			if (!geometryOnly || child->type() == QSGNode::GeometryNodeType)
+				++count;
+			count += countNodes(child, geometryOnly);
+		}
+		return count;
+	}
+
+	/** Returns the count of distinct materials of the geometry nodes below the roots. */
+	static int countMaterials(const std::vector<std::unique_ptr<DisplayNode>>& roots)
+	{
+		QSet<const QSGMaterial*> materials;
+		for (const std::unique_ptr<DisplayNode>& root : roots)
+			collectMaterials(root.get(), materials);
+		return materials.size();
+	}
+	static void collectMaterials(const QSGNode* root, QSet<const QSGMaterial*>& materials)
+	{
+		for (const QSGNode* child = root->firstChild(); child; child = child->nextSibling())
+		{
+			if (child->type() == QSGNode::GeometryNodeType)
+				materials.insert(static_cast<const QSGGeometryNode*>(child)->material());
+			collectMaterials(child, materials);
+		}
+	}
+
+	static QString pattern(int digits, char c)
+	{
+		return QString(digits, QLatin1Char(c));
+	}
+
+	static void prepare(DisplayNode& node, int digits, int mode)
+	{
+		node.setDigitCount(digits);
+		node.setRenderMode(static_cast<SevenSegmentDisplay::RenderMode>(mode));
+		node.update(bounds);
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	// Run headless unless a platform is requested explicitly
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QGuiApplication app(argc, argv);
+	DisplayTest test;
+	return QTest::qExec(&test, argc, argv);
+}
+
+#include "displaytest.moc"